@@ -1,11 +1,22 @@
 #define _USE_MATH_DEFINES
 
 #include "ant.hpp"
+#include "randomstreams.hpp"
 
 #include <cmath>
 #include <math.h>
 #include <random>
 
+const double Ant::defaultSpeed{3};
+const double Ant::wanderRange{3.14/6};
+const double Ant::maxPheromoneStrength{400};
+const double Ant::diminishPheromoneValue{1.5};
+const int Ant::smellRange{12};
+const double Ant::pheromoneTurnAngle{3.14/8};
+const int Ant::sightRange{30};
+const double Ant::obstacleTurnAngle{3.14/6};
+const int Ant::cornerTolerance{0};
+
 Ant::Ant(){}
 
 Ant::Ant(const Vector3D& initialLocation, const double& initialOrientation):
@@ -26,7 +37,9 @@ double Ant::get_orientation()
 
 Vector3D Ant::get_orientation_vector()
 {
-    return Vector3D(cos(orientationAngle), sin(orientationAngle), 0);
+    double sine, cosine;
+    trig_sin_cos(trigMode, orientationAngle, sine, cosine);
+    return Vector3D(cosine, sine, 0);
 }
 
 double Ant::get_speed()
@@ -54,11 +67,36 @@ double Ant::get_pheromone_turn_angle()
     return pheromoneTurnAngle;
 }
 
-double Ant::get_sight_range()
+int Ant::get_sight_range()
 {
     return sightRange;
 }
 
+double Ant::get_max_pheromone_strength()
+{
+    return maxPheromoneStrength;
+}
+
+int Ant::get_smell_range()
+{
+    return smellRange;
+}
+
+TrigMode Ant::get_trig_mode()
+{
+    return trigMode;
+}
+
+void Ant::set_trig_mode(const TrigMode& mode)
+{
+    trigMode = mode;
+}
+
+double Ant::get_diminish_pheromone_value()
+{
+    return diminishPheromoneValue;
+}
+
 void Ant::diminish_pheromone_strength()
 {
     if (pheromoneStrength > diminishPheromoneValue)
@@ -91,14 +129,26 @@ void Ant::set_orientation(const double& newOrientation)
     orientationAngle = newOrientation;
 }
 
+void Ant::set_pheromone_strength(const double& newPheromoneStrength)
+{
+    pheromoneStrength = newPheromoneStrength;
+}
+
 void Ant::move()
 {
     locationVector = locationVector + speed*get_orientation_vector();
 }
 
-void Ant::turn(const PheromoneGrid& pheromones, const ObstacleGrid& obstacles, const std::vector<Food>& foodVector, const Colony& colony)
+void Ant::turn(const PheromoneGrid& pheromones, const ObstacleGrid& obstacles, const FoodIndex& foodIndex, const Colony& colony)
+{
+    turn(pheromones, obstacles, foodIndex, colony, generate_random_double(0,1), generate_random_double(0,1));
+}
+
+// The rolls are uniform values in [0,1) so the caller decides where the
+// randomness comes from; identical rolls give identical turns.
+void Ant::turn(const PheromoneGrid& pheromones, const ObstacleGrid& obstacles, const FoodIndex& foodIndex, const Colony& colony, const double& wanderRoll, const double& cornerRoll)
 {
-    wander();
+    wander(wanderRoll);
 
     turn_towards_pheromones(pheromones);
 
@@ -108,15 +158,20 @@ void Ant::turn(const PheromoneGrid& pheromones, const ObstacleGrid& obstacles, c
     }
     else
     {
-        look_for_food(foodVector);
+        look_for_food(foodIndex);
     }
 
-    turn_to_avoid_obstacles(obstacles);
+    turn_to_avoid_obstacles(obstacles, cornerRoll);
 }
 
 void Ant::wander()
 {
-    orientationAngle = orientationAngle - wanderRange/2 + generate_random_double(0, wanderRange);
+    wander(generate_random_double(0,1));
+}
+
+void Ant::wander(const double& wanderRoll)
+{
+    orientationAngle = orientationAngle - wanderRange/2 + wanderRoll*wanderRange;
 
     if (orientationAngle >= 2*M_PI)
     {
@@ -155,20 +210,25 @@ void Ant::turn_towards_pheromones(const PheromoneGrid &pheromones)
 }
 
 void Ant::look_for_food(const std::vector<Food>& foodVector)
+{
+    FoodIndex foodIndex{0, 0, sightRange};
+    for (int i = 0; i < foodVector.size(); i++)
+    {
+        foodIndex.add(foodVector[i]);
+    }
+    look_for_food(foodIndex);
+}
+
+// Heads for the nearest pile in sight.
+void Ant::look_for_food(const FoodIndex& foodIndex)
 {
     int x = locationVector[0];
     int y = locationVector[1];
 
-    for (int i = 0; i < foodVector.size(); i++)
+    int nearest = foodIndex.find_nearest(x, y, sightRange);
+    if (nearest >= 0)
     {
-        Vector3D foodLocation = foodVector[i].get_location();
-        if (abs(foodLocation[0]- x) < sightRange)
-        {
-            if (abs(foodLocation[1]-y) < sightRange)
-            {
-                orientationAngle = get_angle_to_point(locationVector, foodLocation);
-            }
-        }
+        orientationAngle = get_angle_to_point(locationVector, foodIndex.get_food(nearest).get_location(), trigMode);
     }
 }
 
@@ -182,21 +242,21 @@ void Ant::look_for_colony(const Colony& colony)
     {
         if (abs(colonyLocation[1]-y) < sightRange)
         {
-            orientationAngle = get_angle_to_point(locationVector, colonyLocation);
+            orientationAngle = get_angle_to_point(locationVector, colonyLocation, trigMode);
         }
     }
 }
 
 void Ant::turn_to_avoid_obstacles(const ObstacleGrid &obstacles)
 {
-    bool obstacleInFront = obstacles.check_for_obstacle_front(locationVector, orientationAngle, sightRange);
-    if (obstacleInFront)
-    {
-        double rightAngle = orientationAngle + obstacleTurnAngle;
-        double leftAngle = orientationAngle - obstacleTurnAngle;
-        int rightDistance = obstacles.check_obstacle_distance(locationVector, rightAngle, sightRange);
-        int leftDistance = obstacles.check_obstacle_distance(locationVector, leftAngle, sightRange);
+    turn_to_avoid_obstacles(obstacles, generate_random_double(0,1));
+}
 
+void Ant::turn_to_avoid_obstacles(const ObstacleGrid &obstacles, const double& cornerRoll)
+{
+    int rightDistance, leftDistance;
+    if (obstacles.cast_avoidance_rays(locationVector, orientationAngle, obstacleTurnAngle, sightRange, rightDistance, leftDistance))
+    {
         if (rightDistance < leftDistance - cornerTolerance)
         {
             orientationAngle -= obstacleTurnAngle;
@@ -207,17 +267,21 @@ void Ant::turn_to_avoid_obstacles(const ObstacleGrid &obstacles)
         }
         else
         {
-            corner_evasive_action(rightDistance, leftDistance);
+            corner_evasive_action(rightDistance, leftDistance, cornerRoll);
         }
     }
 }
 
 void Ant::corner_evasive_action(const int &rightDistance, const int &leftDistance)
+{
+    corner_evasive_action(rightDistance, leftDistance, generate_random_double(0,1));
+}
+
+void Ant::corner_evasive_action(const int &rightDistance, const int &leftDistance, const double& cornerRoll)
 {
     if (rightDistance > sightRange-1 && leftDistance > sightRange-1)
     {
-        double randomDouble = generate_random_double(0,1);
-        if (randomDouble > .5)
+        if (cornerRoll > .5)
         {
             orientationAngle += 3.14/4;
         }
@@ -257,6 +321,11 @@ void Ant::turn_if_at_boundary(const int& width, const int& height)
 }
 
 double get_angle_to_point(const Vector3D &initialLocation, const Vector3D &targetLocation)
+{
+    return get_angle_to_point(initialLocation, targetLocation, libmTrig);
+}
+
+double get_angle_to_point(const Vector3D &initialLocation, const Vector3D &targetLocation, const TrigMode& trigMode)
 {
     Vector3D orientationV = initialLocation - targetLocation;
     double dx = orientationV[0];
@@ -264,18 +333,18 @@ double get_angle_to_point(const Vector3D &initialLocation, const Vector3D &targe
 
     if (dx >= 0)
     {
-        return atan(dy/dx)+ 3.14159;
+        return trig_atan(trigMode, dy/dx)+ 3.14159;
     }
     else
     {
-        return atan(dy/dx);
+        return trig_atan(trigMode, dy/dx);
     }
 }
 
+// One generator per thread, seeded once; the entropy read used to happen on
+// every call.
 double generate_random_double(double minValue, double maxValue)
 {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(minValue, maxValue);
-    return dis(gen);
+    thread_local PcgStream stream{std::random_device{}(), std::random_device{}()};
+    return stream.next_double(minValue, maxValue);
 }
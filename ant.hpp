@@ -6,6 +6,8 @@
 #include "obstaclegrid.hpp"
 #include "colony.hpp"
 #include "food.hpp"
+#include "foodindex.hpp"
+#include "fastmath.hpp"
 
 class Ant
 {
@@ -23,7 +25,12 @@ public:
     double get_pheromone_strength();
     double get_obstacle_turn_angle();
     double get_pheromone_turn_angle();
-    double get_sight_range();
+    static int get_sight_range();
+    static double get_max_pheromone_strength();
+    static double get_diminish_pheromone_value();
+    static int get_smell_range();
+    TrigMode get_trig_mode();
+    void set_trig_mode(const TrigMode& mode);
 
     void diminish_pheromone_strength();
     void reset_pheromone_strength();
@@ -31,37 +38,45 @@ public:
     bool has_food();
     void set_has_food(const bool& newHasFood);
     void set_orientation(const double& newOrientation);
+    void set_pheromone_strength(const double& newPheromoneStrength);
 
     void move();
-    void turn(const PheromoneGrid& pheromones, const ObstacleGrid& obstacles, const std::vector<Food>& foodVector, const Colony& colony);
+    void turn(const PheromoneGrid& pheromones, const ObstacleGrid& obstacles, const FoodIndex& foodIndex, const Colony& colony);
+    void turn(const PheromoneGrid& pheromones, const ObstacleGrid& obstacles, const FoodIndex& foodIndex, const Colony& colony, const double& wanderRoll, const double& cornerRoll);
     void wander();
+    void wander(const double& wanderRoll);
     void turn_towards_pheromones(const PheromoneGrid& pheromones);
     void look_for_food(const std::vector<Food>& foodVector);
+    void look_for_food(const FoodIndex& foodIndex);
     void look_for_colony(const Colony& colony);
     void turn_to_avoid_obstacles(const ObstacleGrid& obstacles);
+    void turn_to_avoid_obstacles(const ObstacleGrid& obstacles, const double& cornerRoll);
     void corner_evasive_action(const int& rightDistance, const int& leftDistance);
+    void corner_evasive_action(const int& rightDistance, const int& leftDistance, const double& cornerRoll);
     void turn_if_at_boundary(const int& width, const int& height);
 
 protected:
     Vector3D locationVector{0,0,0};
     double orientationAngle{0};
-    double defaultSpeed{3};
     double speed{defaultSpeed};
     bool hasFood{false};
-    double wanderRange{3.14/6};
-    double maxPheromoneStrength{400};
     double pheromoneStrength{0};
-    double diminishPheromoneValue{1.5};
-    int smellRange{12};
-    double pheromoneTurnAngle{3.14/8};
-    int sightRange{30};
-    double obstacleTurnAngle{3.14/6};
-    int cornerTolerance{0};
+    TrigMode trigMode{libmTrig};
 
-    double pi = 3.141592654;
+    // Shared by every ant, so they are kept out of the per-ant state.
+    static const double defaultSpeed;
+    static const double wanderRange;
+    static const double maxPheromoneStrength;
+    static const double diminishPheromoneValue;
+    static const int smellRange;
+    static const double pheromoneTurnAngle;
+    static const int sightRange;
+    static const double obstacleTurnAngle;
+    static const int cornerTolerance;
 };
 
 double get_angle_to_point(const Vector3D& initialLocation, const Vector3D& targetLocation);
+double get_angle_to_point(const Vector3D& initialLocation, const Vector3D& targetLocation, const TrigMode& trigMode);
 
 double generate_random_double(double minValue, double maxValue);
 
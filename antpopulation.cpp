@@ -0,0 +1,248 @@
+#include "antpopulation.hpp"
+
+AntPopulation::AntPopulation(){}
+
+int AntPopulation::size() const
+{
+    return xPositions.size();
+}
+
+bool AntPopulation::empty() const
+{
+    return xPositions.empty();
+}
+
+void AntPopulation::clear()
+{
+    xPositions.clear();
+    yPositions.clear();
+    orientations.clear();
+    pheromoneStrengths.clear();
+    hasFoodBits.clear();
+}
+
+void AntPopulation::reserve(const int& capacity)
+{
+    xPositions.reserve(capacity);
+    yPositions.reserve(capacity);
+    orientations.reserve(capacity);
+    pheromoneStrengths.reserve(capacity);
+    hasFoodBits.reserve((capacity+63)/64);
+}
+
+void AntPopulation::add_ant(const Vector3D& locationVector, const double& orientationAngle)
+{
+    Ant ant{locationVector, orientationAngle};
+    add_ant(ant);
+}
+
+void AntPopulation::add_ant(const Ant& ant)
+{
+    Ant newAnt = ant;
+    int index = size();
+
+    xPositions.push_back(newAnt.get_location()[0]);
+    yPositions.push_back(newAnt.get_location()[1]);
+    orientations.push_back(newAnt.get_orientation());
+    pheromoneStrengths.push_back(newAnt.get_pheromone_strength());
+    if (index % 64 == 0)
+    {
+        hasFoodBits.push_back(0);
+    }
+    set_has_food(index, newAnt.has_food());
+}
+
+void AntPopulation::remove_ant(const int& index)
+{
+    int lastIndex = size() - 1;
+    for (int i = index; i < lastIndex; i++)
+    {
+        set_has_food(i, has_food(i+1));
+    }
+
+    xPositions.erase(xPositions.begin()+index);
+    yPositions.erase(yPositions.begin()+index);
+    orientations.erase(orientations.begin()+index);
+    pheromoneStrengths.erase(pheromoneStrengths.begin()+index);
+    if (lastIndex % 64 == 0)
+    {
+        hasFoodBits.pop_back();
+    }
+    else
+    {
+        set_has_food(lastIndex, false);
+    }
+}
+
+// Marks every ant closer than radius to the segment; marks already set stay,
+// so several strokes can be collected before one removal.
+void AntPopulation::mark_ants_near_segment(const Vector3D& start, const Vector3D& end, const double& radius, std::vector<bool>& marked) const
+{
+    if (marked.size() < size())
+    {
+        marked.resize(size(), false);
+    }
+    for (int i = 0; i < size(); i++)
+    {
+        if (distance_squared_to_segment(Vector3D(xPositions[i], yPositions[i], 0), start, end) < radius*radius)
+        {
+            marked[i] = true;
+        }
+    }
+}
+
+// Stable compaction: the remaining ants keep their order. Returns how many
+// ants were removed.
+int AntPopulation::remove_marked_ants(const std::vector<bool>& marked)
+{
+    int count = size();
+    int kept = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (i < marked.size() && marked[i])
+        {
+            continue;
+        }
+        if (kept != i)
+        {
+            xPositions[kept] = xPositions[i];
+            yPositions[kept] = yPositions[i];
+            orientations[kept] = orientations[i];
+            pheromoneStrengths[kept] = pheromoneStrengths[i];
+            set_has_food(kept, has_food(i));
+        }
+        kept++;
+    }
+
+    xPositions.resize(kept);
+    yPositions.resize(kept);
+    orientations.resize(kept);
+    pheromoneStrengths.resize(kept);
+    hasFoodBits.resize((kept + 63)/64);
+    if (kept % 64 != 0)
+    {
+        hasFoodBits.back() &= (std::uint64_t(1) << (kept % 64)) - 1;
+    }
+    return count - kept;
+}
+
+Ant AntPopulation::get_ant(const int& index) const
+{
+    Ant ant{get_location(index), orientations[index]};
+    ant.set_has_food(has_food(index));
+    ant.set_pheromone_strength(pheromoneStrengths[index]);
+    return ant;
+}
+
+void AntPopulation::set_ant(const int& index, Ant& ant)
+{
+    set_location(index, ant.get_location());
+    orientations[index] = ant.get_orientation();
+    pheromoneStrengths[index] = ant.get_pheromone_strength();
+    set_has_food(index, ant.has_food());
+}
+
+std::vector<Ant> AntPopulation::get_ants() const
+{
+    std::vector<Ant> ants;
+    ants.reserve(size());
+    for (int i = 0; i < size(); i++)
+    {
+        ants.push_back(get_ant(i));
+    }
+    return ants;
+}
+
+Vector3D AntPopulation::get_location(const int& index) const
+{
+    return Vector3D(xPositions[index], yPositions[index], 0);
+}
+
+void AntPopulation::set_location(const int& index, const Vector3D& locationVector)
+{
+    xPositions[index] = locationVector[0];
+    yPositions[index] = locationVector[1];
+}
+
+double AntPopulation::get_orientation(const int& index) const
+{
+    return orientations[index];
+}
+
+void AntPopulation::set_orientation(const int& index, const double& orientationAngle)
+{
+    orientations[index] = orientationAngle;
+}
+
+double AntPopulation::get_pheromone_strength(const int& index) const
+{
+    return pheromoneStrengths[index];
+}
+
+void AntPopulation::set_pheromone_strength(const int& index, const double& pheromoneStrength)
+{
+    pheromoneStrengths[index] = pheromoneStrength;
+}
+
+bool AntPopulation::has_food(const int& index) const
+{
+    return (hasFoodBits[index/64] >> (index%64)) & 1;
+}
+
+void AntPopulation::set_has_food(const int& index, const bool& hasFood)
+{
+    std::uint64_t mask = std::uint64_t(1) << (index%64);
+    if (hasFood)
+    {
+        hasFoodBits[index/64] |= mask;
+    }
+    else
+    {
+        hasFoodBits[index/64] &= ~mask;
+    }
+}
+
+std::vector<double>& AntPopulation::get_x_positions()
+{
+    return xPositions;
+}
+
+std::vector<double>& AntPopulation::get_y_positions()
+{
+    return yPositions;
+}
+
+std::vector<double>& AntPopulation::get_orientations()
+{
+    return orientations;
+}
+
+std::vector<double>& AntPopulation::get_pheromone_strengths()
+{
+    return pheromoneStrengths;
+}
+
+const std::vector<double>& AntPopulation::get_x_positions() const
+{
+    return xPositions;
+}
+
+const std::vector<double>& AntPopulation::get_y_positions() const
+{
+    return yPositions;
+}
+
+const std::vector<double>& AntPopulation::get_orientations() const
+{
+    return orientations;
+}
+
+const std::vector<double>& AntPopulation::get_pheromone_strengths() const
+{
+    return pheromoneStrengths;
+}
+
+const std::vector<std::uint64_t>& AntPopulation::get_has_food_bits() const
+{
+    return hasFoodBits;
+}
@@ -0,0 +1,60 @@
+#ifndef ANTPOPULATION_HPP
+#define ANTPOPULATION_HPP
+
+#include "ant.hpp"
+#include "vector3D.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Structure-of-arrays store for the ants of a World. Each field lives in its
+// own contiguous array so a phase only streams the fields it touches.
+// get_ant() builds a lightweight Ant view for code that wants the Ant API.
+class AntPopulation
+{
+public:
+    AntPopulation();
+
+    int size() const;
+    bool empty() const;
+    void clear();
+    void reserve(const int& capacity);
+
+    void add_ant(const Vector3D& locationVector, const double& orientationAngle);
+    void add_ant(const Ant& ant);
+    void remove_ant(const int& index);
+    void mark_ants_near_segment(const Vector3D& start, const Vector3D& end, const double& radius, std::vector<bool>& marked) const;
+    int remove_marked_ants(const std::vector<bool>& marked);
+
+    Ant get_ant(const int& index) const;
+    void set_ant(const int& index, Ant& ant);
+    std::vector<Ant> get_ants() const;
+
+    Vector3D get_location(const int& index) const;
+    void set_location(const int& index, const Vector3D& locationVector);
+    double get_orientation(const int& index) const;
+    void set_orientation(const int& index, const double& orientationAngle);
+    double get_pheromone_strength(const int& index) const;
+    void set_pheromone_strength(const int& index, const double& pheromoneStrength);
+    bool has_food(const int& index) const;
+    void set_has_food(const int& index, const bool& hasFood);
+
+    std::vector<double>& get_x_positions();
+    std::vector<double>& get_y_positions();
+    std::vector<double>& get_orientations();
+    std::vector<double>& get_pheromone_strengths();
+    const std::vector<double>& get_x_positions() const;
+    const std::vector<double>& get_y_positions() const;
+    const std::vector<double>& get_orientations() const;
+    const std::vector<double>& get_pheromone_strengths() const;
+    const std::vector<std::uint64_t>& get_has_food_bits() const;
+
+protected:
+    std::vector<double> xPositions;
+    std::vector<double> yPositions;
+    std::vector<double> orientations;
+    std::vector<double> pheromoneStrengths;
+    std::vector<std::uint64_t> hasFoodBits;
+};
+
+#endif // ANTPOPULATION_HPP
@@ -0,0 +1,422 @@
+#include "fastmath.hpp"
+#include "rendersnapshot.hpp"
+#include "world.hpp"
+
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Run with --benchmark_out=results.json --benchmark_out_format=json to keep
+// results for comparison; the run_benchmarks target does this for you.
+
+//############################################################
+//Trigonometry Benchmarks
+//############################################################
+
+static std::vector<double> make_angles()
+{
+    std::vector<double> angles(4096);
+    for (int i = 0; i < angles.size(); i++)
+    {
+        angles[i] = -10 + 20.0*i/angles.size();
+    }
+    return angles;
+}
+
+static void BM_LibmSinCos(benchmark::State& state)
+{
+    std::vector<double> angles = make_angles();
+    for (auto _ : state)
+    {
+        double sum{0};
+        for (int i = 0; i < angles.size(); i++)
+        {
+            sum += std::sin(angles[i]) + std::cos(angles[i]);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations()*angles.size());
+}
+BENCHMARK(BM_LibmSinCos);
+
+static void BM_FastSinCos(benchmark::State& state)
+{
+    std::vector<double> angles = make_angles();
+    for (auto _ : state)
+    {
+        double sum{0};
+        for (int i = 0; i < angles.size(); i++)
+        {
+            double sine, cosine;
+            fast_sin_cos(angles[i], sine, cosine);
+            sum += sine + cosine;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations()*angles.size());
+}
+BENCHMARK(BM_FastSinCos);
+
+static void BM_LibmAtan2(benchmark::State& state)
+{
+    std::vector<double> angles = make_angles();
+    for (auto _ : state)
+    {
+        double sum{0};
+        for (int i = 0; i < angles.size(); i++)
+        {
+            sum += std::atan2(angles[i], angles[angles.size() - 1 - i]);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations()*angles.size());
+}
+BENCHMARK(BM_LibmAtan2);
+
+static void BM_FastAtan2(benchmark::State& state)
+{
+    std::vector<double> angles = make_angles();
+    for (auto _ : state)
+    {
+        double sum{0};
+        for (int i = 0; i < angles.size(); i++)
+        {
+            sum += fast_atan2(angles[i], angles[angles.size() - 1 - i]);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations()*angles.size());
+}
+BENCHMARK(BM_FastAtan2);
+
+static void BM_WorldUpdateTrigMode(benchmark::State& state)
+{
+    World world{800, 600, static_cast<TrigMode>(state.range(0))};
+    world.set_random_seed(1);
+    world.add_food(200, 150, 500);
+    world.add_colony(400, 300);
+    for (int i = 0; i < 2000; i++)
+    {
+        world.add_ant(Vector3D(400, 300, 0), i*0.01);
+    }
+
+    for (auto _ : state)
+    {
+        world.update();
+    }
+    state.SetItemsProcessed(state.iterations()*2000);
+}
+BENCHMARK(BM_WorldUpdateTrigMode)->Arg(libmTrig)->Arg(fastTrig)->Unit(benchmark::kMillisecond);
+
+//############################################################
+//Fixture Helpers
+//############################################################
+
+// Obstacle densities are approximate: circles are placed until their summed
+// area reaches the requested percentage, and overlaps are not discounted.
+static const int obstacleRadius = 8;
+
+static int get_obstacle_circle_count(const int& width, const int& height, const int& densityPercent)
+{
+    return int(width*height*densityPercent/(100*3.141592654*obstacleRadius*obstacleRadius));
+}
+
+static ObstacleGrid make_obstacle_grid(const int& width, const int& height, const int& densityPercent)
+{
+    ObstacleGrid obstacles{width, height};
+    obstacles.fill_borders();
+    PcgStream stream{1, 1};
+    for (int i = 0; i < get_obstacle_circle_count(width, height, densityPercent); i++)
+    {
+        obstacles.add_obstacle_circle(int(stream.next_double(0, width)), int(stream.next_double(0, height)), obstacleRadius);
+    }
+    return obstacles;
+}
+
+// Trails of overlapping deposits, roughly what a few hundred ticks of
+// foraging leave behind.
+static PheromoneGrid make_pheromone_grid(const int& width, const int& height)
+{
+    PheromoneGrid pheromones{width, height, 1};
+    PcgStream stream{2, 1};
+    for (int i = 0; i < width*height/64; i++)
+    {
+        int x = int(stream.next_double(3, width - 3));
+        int y = int(stream.next_double(3, height - 3));
+        pheromones.spread_home_pheromone(x, y, int(stream.next_double(1, 1000)), 3);
+        pheromones.spread_food_pheromone(width - 1 - x, y, int(stream.next_double(1, 1000)), 3);
+    }
+    return pheromones;
+}
+
+static std::vector<Ant> make_scattered_ants(const int& width, const int& height, const int& antCount)
+{
+    std::vector<Ant> ants;
+    PcgStream stream{3, 1};
+    for (int i = 0; i < antCount; i++)
+    {
+        double x = stream.next_double(20, width - 20);
+        double y = stream.next_double(20, height - 20);
+        ants.push_back(Ant{Vector3D(x, y, 0), stream.next_double(0, 2*3.141592654)});
+    }
+    return ants;
+}
+
+// A world with a colony in the middle, food piles scattered around it and
+// the ants spread over the map so every phase has work from the first tick.
+static World make_world(const int& size, const int& antCount, const int& densityPercent)
+{
+    World world{size, size};
+    world.set_random_seed(1);
+    world.set_obstacle_distance_field(true);
+    PcgStream stream{4, 1};
+    for (int i = 0; i < get_obstacle_circle_count(size, size, densityPercent); i++)
+    {
+        world.add_obstacle(int(stream.next_double(0, size)), int(stream.next_double(0, size)), obstacleRadius);
+    }
+    for (int i = 0; i < 16; i++)
+    {
+        world.add_food(int(stream.next_double(20, size - 20)), int(stream.next_double(20, size - 20)), 1000);
+    }
+    world.add_colony(size/2, size/2, 0);
+    std::vector<Ant> ants = make_scattered_ants(size, size, antCount);
+    for (int i = 0; i < ants.size(); i++)
+    {
+        world.add_ant(ants[i].get_location(), ants[i].get_orientation());
+    }
+    return world;
+}
+
+//############################################################
+//Pheromone Benchmarks
+//############################################################
+
+static void BM_DecayAllPheromones(benchmark::State& state)
+{
+    int size = state.range(0);
+    PheromoneGrid pheromones = make_pheromone_grid(size, size);
+    pheromones.set_lazy_decay(state.range(1));
+
+    for (auto _ : state)
+    {
+        pheromones.decay_all_pheromones();
+    }
+    state.SetItemsProcessed(state.iterations()*size*size);
+}
+BENCHMARK(BM_DecayAllPheromones)->ArgNames({"size", "lazy"})->ArgsProduct({{256, 1024, 2048}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+typedef double (PheromoneGrid::*PheromoneSensor)(const Vector3D&, const double&, const int&) const;
+
+static void BM_AveragePheromones(benchmark::State& state, PheromoneSensor sensor)
+{
+    int size = state.range(0);
+    PheromoneGrid pheromones = make_pheromone_grid(size, size);
+    pheromones.set_sensing_mode(static_cast<SensingMode>(state.range(1)));
+    if (pheromones.get_sensing_mode() == summedAreaSensing)
+    {
+        pheromones.build_summed_area_tables();
+    }
+    else if (pheromones.get_sensing_mode() == stencilSensing)
+    {
+        pheromones.build_sensing_stencils(Ant::get_smell_range(), 256);
+    }
+    std::vector<Ant> ants = make_scattered_ants(size, size, 4096);
+
+    for (auto _ : state)
+    {
+        double sum{0};
+        for (int i = 0; i < ants.size(); i++)
+        {
+            sum += (pheromones.*sensor)(ants[i].get_location(), ants[i].get_orientation(), Ant::get_smell_range());
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations()*ants.size());
+}
+BENCHMARK_CAPTURE(BM_AveragePheromones, food_right, &PheromoneGrid::average_food_pheromones_right)
+    ->ArgNames({"size", "sensing"})->ArgsProduct({{256, 2048}, {exactSensing, summedAreaSensing, stencilSensing}})->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_AveragePheromones, food_left, &PheromoneGrid::average_food_pheromones_left)
+    ->ArgNames({"size", "sensing"})->ArgsProduct({{256, 2048}, {exactSensing, summedAreaSensing, stencilSensing}})->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_AveragePheromones, home_right, &PheromoneGrid::average_home_pheromones_right)
+    ->ArgNames({"size", "sensing"})->ArgsProduct({{256, 2048}, {exactSensing, summedAreaSensing, stencilSensing}})->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_AveragePheromones, home_left, &PheromoneGrid::average_home_pheromones_left)
+    ->ArgNames({"size", "sensing"})->ArgsProduct({{256, 2048}, {exactSensing, summedAreaSensing, stencilSensing}})->Unit(benchmark::kMicrosecond);
+
+typedef void (PheromoneGrid::*PheromoneSpreader)(const int&, const int&, const int&, const int&);
+
+static void BM_SpreadPheromone(benchmark::State& state, PheromoneSpreader spreader)
+{
+    PheromoneGrid pheromones{1024, 1024, 1};
+    std::vector<Ant> ants = make_scattered_ants(1024, 1024, 4096);
+    int spread = state.range(0);
+
+    for (auto _ : state)
+    {
+        for (int i = 0; i < ants.size(); i++)
+        {
+            Vector3D location = ants[i].get_location();
+            (pheromones.*spreader)(int(location[0]), int(location[1]), 10, spread);
+        }
+    }
+    state.SetItemsProcessed(state.iterations()*ants.size());
+}
+BENCHMARK_CAPTURE(BM_SpreadPheromone, home, &PheromoneGrid::spread_home_pheromone)->ArgName("spread")->Arg(1)->Arg(3)->Arg(8)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_SpreadPheromone, food, &PheromoneGrid::spread_food_pheromone)->ArgName("spread")->Arg(1)->Arg(3)->Arg(8)->Unit(benchmark::kMicrosecond);
+
+//############################################################
+//Obstacle Benchmarks
+//############################################################
+
+static void BM_CheckObstacleDistance(benchmark::State& state)
+{
+    ObstacleGrid obstacles = make_obstacle_grid(1024, 1024, state.range(0));
+    obstacles.set_distance_field_enabled(state.range(1));
+    if (obstacles.is_distance_field_enabled())
+    {
+        obstacles.build_distance_field();
+    }
+    std::vector<Ant> ants = make_scattered_ants(1024, 1024, 4096);
+
+    for (auto _ : state)
+    {
+        int sum{0};
+        for (int i = 0; i < ants.size(); i++)
+        {
+            sum += obstacles.check_obstacle_distance(ants[i].get_location(), ants[i].get_orientation(), Ant::get_sight_range());
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations()*ants.size());
+}
+BENCHMARK(BM_CheckObstacleDistance)->ArgNames({"density", "distanceField"})->ArgsProduct({{0, 10, 30}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+static void BM_GenerateRandomCaves(benchmark::State& state)
+{
+    int size = state.range(0);
+    ObstacleGrid obstacles{size, size};
+
+    for (auto _ : state)
+    {
+        PcgStream stream{5, 1};
+        obstacles.generate_random_caves(stream);
+    }
+    state.SetItemsProcessed(state.iterations()*size*size);
+}
+BENCHMARK(BM_GenerateRandomCaves)->ArgName("size")->Arg(256)->Arg(1024)->Arg(2048)->Unit(benchmark::kMillisecond);
+
+//############################################################
+//Ant And World Benchmarks
+//############################################################
+
+static void BM_AntTurn(benchmark::State& state)
+{
+    int size = 1024;
+    PheromoneGrid pheromones = make_pheromone_grid(size, size);
+    ObstacleGrid obstacles = make_obstacle_grid(size, size, state.range(0));
+    FoodIndex foodIndex{size, size, Ant::get_sight_range()};
+    PcgStream stream{6, 1};
+    for (int i = 0; i < 16; i++)
+    {
+        foodIndex.add(Food{int(stream.next_double(20, size - 20)), int(stream.next_double(20, size - 20)), 1000});
+    }
+    Colony colony{size/2, size/2};
+    std::vector<Ant> ants = make_scattered_ants(size, size, 4096);
+
+    for (auto _ : state)
+    {
+        for (int i = 0; i < ants.size(); i++)
+        {
+            ants[i].turn(pheromones, obstacles, foodIndex, colony, stream.next_unit(), stream.next_unit());
+        }
+    }
+    state.SetItemsProcessed(state.iterations()*ants.size());
+}
+BENCHMARK(BM_AntTurn)->ArgName("density")->Arg(0)->Arg(10)->Arg(30)->Unit(benchmark::kMillisecond);
+
+// Each iteration works on a fresh copy, otherwise the ants that pick up food
+// in the first iteration skip the search in every later one.
+static void BM_WorldCollectFood(benchmark::State& state)
+{
+    World world = make_world(1024, state.range(0), 0);
+    PcgStream stream{7, 1};
+    for (int i = 0; i < state.range(1); i++)
+    {
+        world.add_food(int(stream.next_double(2, 1022)), int(stream.next_double(2, 1022)), 1000);
+    }
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        World collectingWorld = world;
+        state.ResumeTiming();
+        collectingWorld.collect_food();
+    }
+    state.SetItemsProcessed(state.iterations()*state.range(0));
+}
+BENCHMARK(BM_WorldCollectFood)->ArgNames({"ants", "food"})->ArgsProduct({{1000, 20000}, {0, 100, 2000}})->Unit(benchmark::kMicrosecond);
+
+// The label carries the state hash after the timed ticks, so a change that
+// alters behaviour rather than speed shows up in the JSON. The iteration
+// count is fixed so the hash is comparable between runs.
+static void BM_WorldUpdate(benchmark::State& state)
+{
+    World world = make_world(state.range(0), state.range(1), state.range(2));
+    world.set_thread_count(state.range(3));
+
+    for (auto _ : state)
+    {
+        world.update();
+    }
+    state.SetItemsProcessed(state.iterations()*state.range(1));
+    char label[32];
+    std::snprintf(label, sizeof(label), "hash %016llx", (unsigned long long)world.get_state_hash());
+    state.SetLabel(label);
+}
+BENCHMARK(BM_WorldUpdate)->ArgNames({"size", "ants", "density", "threads"})
+    ->ArgsProduct({{512, 2048}, {1000, 20000}, {0, 20}, {1}})
+    ->Args({2048, 20000, 20, 4})
+    ->Iterations(25)->Unit(benchmark::kMillisecond);
+
+static void BM_WorldUpdateMode(benchmark::State& state)
+{
+    World world = make_world(2048, state.range(1), 10);
+    world.set_update_mode(static_cast<UpdateMode>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        world.update();
+    }
+    state.SetItemsProcessed(state.iterations()*state.range(1));
+    char label[32];
+    std::snprintf(label, sizeof(label), "hash %016llx", (unsigned long long)world.get_state_hash());
+    state.SetLabel(label);
+}
+BENCHMARK(BM_WorldUpdateMode)->ArgNames({"fused", "ants"})->ArgsProduct({{phasedUpdate, fusedUpdate}, {20000, 200000}})
+    ->Iterations(10)->Unit(benchmark::kMillisecond);
+
+//############################################################
+//Render Benchmarks
+//############################################################
+
+// Scattered ants lay trails over the whole map, so every pheromone tile is
+// active and each capture recomposes all of it.
+static void BM_CaptureRenderSnapshot(benchmark::State& state)
+{
+    World world = make_world(state.range(0), 20000, 0);
+    world.set_lazy_pheromone_decay(state.range(1));
+    for (int tick = 0; tick < 40; tick++)
+    {
+        world.update();
+    }
+    RenderSnapshot snapshot;
+
+    for (auto _ : state)
+    {
+        snapshot.capture(world, 0, 0);
+    }
+    state.SetItemsProcessed(state.iterations()*world.view_pheromones().get_cell_count());
+}
+BENCHMARK(BM_CaptureRenderSnapshot)->ArgNames({"size", "lazy"})->ArgsProduct({{512, 2048}, {0, 1}})->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
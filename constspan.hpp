@@ -0,0 +1,29 @@
+#ifndef CONSTSPAN_HPP
+#define CONSTSPAN_HPP
+
+#include <vector>
+
+// Read-only window onto contiguous storage owned by someone else. It is only
+// valid until the owner next resizes or reallocates that storage, which for
+// the World means until the next update() or edit.
+template <typename T>
+class ConstSpan
+{
+public:
+    ConstSpan() : first(nullptr), count(0) {}
+    ConstSpan(const T* data, const int& size) : first(data), count(size) {}
+    ConstSpan(const std::vector<T>& values) : first(values.data()), count(int(values.size())) {}
+
+    const T* data() const { return first; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T& operator[](const int& index) const { return first[index]; }
+    const T* begin() const { return first; }
+    const T* end() const { return first + count; }
+
+private:
+    const T* first;
+    int count;
+};
+
+#endif // CONSTSPAN_HPP
@@ -0,0 +1,126 @@
+#include "fastmath.hpp"
+
+#include <cmath>
+
+namespace
+{
+const double halfPi = 1.57079632679489661923;
+const double quarterPi = 0.78539816339744830962;
+const double twoOverPi = 0.63661977236758134308;
+const double tanEighthPi = 0.41421356237309504880;
+const double tanThreeEighthsPi = 2.41421356237309504880;
+
+inline double sin_polynomial(const double& x)
+{
+    double z = x*x;
+    return ((-1.9515295891e-4*z + 8.3321608736e-3)*z - 1.6666654611e-1)*z*x + x;
+}
+
+inline double cos_polynomial(const double& x)
+{
+    double z = x*x;
+    return ((2.443315711809948e-5*z - 1.388731625493765e-3)*z + 4.166664568298827e-2)*z*z - 0.5*z + 1.0;
+}
+
+inline double atan_polynomial(const double& x)
+{
+    double z = x*x;
+    return (((8.05374449538e-2*z - 1.38776856032e-1)*z + 1.99777106478e-1)*z - 3.33329491539e-1)*z*x + x;
+}
+}
+
+// The quadrant picks which polynomial to use and its sign:
+// sin(r + k*pi/2) cycles through sin r, cos r, -sin r, -cos r. Rounding by
+// a cast and selecting without branches keeps this free of libm calls.
+void fast_sin_cos(const double& angle, double& sine, double& cosine)
+{
+    long long quadrant = static_cast<long long>(angle*twoOverPi + (angle >= 0 ? 0.5 : -0.5));
+    double reduced = angle - quadrant*halfPi;
+    double s = sin_polynomial(reduced);
+    double c = cos_polynomial(reduced);
+
+    double swappedSine = (quadrant & 1) ? c : s;
+    double swappedCosine = (quadrant & 1) ? s : c;
+    sine = (quadrant & 2) ? -swappedSine : swappedSine;
+    cosine = ((quadrant + 1) & 2) ? -swappedCosine : swappedCosine;
+}
+
+double fast_sin(const double& angle)
+{
+    double sine, cosine;
+    fast_sin_cos(angle, sine, cosine);
+    return sine;
+}
+
+double fast_cos(const double& angle)
+{
+    double sine, cosine;
+    fast_sin_cos(angle, sine, cosine);
+    return cosine;
+}
+
+double fast_atan(const double& value)
+{
+    double magnitude = value < 0 ? -value : value;
+    double result;
+    if (magnitude > tanThreeEighthsPi)
+    {
+        result = halfPi - atan_polynomial(1.0/magnitude);
+    }
+    else if (magnitude > tanEighthPi)
+    {
+        result = quarterPi + atan_polynomial((magnitude - 1.0)/(magnitude + 1.0));
+    }
+    else
+    {
+        result = atan_polynomial(magnitude);
+    }
+    return value < 0 ? -result : result;
+}
+
+double fast_atan2(const double& y, const double& x)
+{
+    if (x == 0)
+    {
+        if (y == 0)
+        {
+            return 0;
+        }
+        return y > 0 ? halfPi : -halfPi;
+    }
+
+    double angle = fast_atan(y/x);
+    if (x < 0)
+    {
+        angle += y < 0 ? -2*halfPi : 2*halfPi;
+    }
+    return angle;
+}
+
+double trig_sin(const TrigMode& mode, const double& angle)
+{
+    return mode == fastTrig ? fast_sin(angle) : std::sin(angle);
+}
+
+double trig_cos(const TrigMode& mode, const double& angle)
+{
+    return mode == fastTrig ? fast_cos(angle) : std::cos(angle);
+}
+
+void trig_sin_cos(const TrigMode& mode, const double& angle, double& sine, double& cosine)
+{
+    if (mode == fastTrig)
+    {
+        fast_sin_cos(angle, sine, cosine);
+    }
+    else
+    {
+        sine = std::sin(angle);
+        cosine = std::cos(angle);
+    }
+}
+
+double trig_atan(const TrigMode& mode, const double& value)
+{
+    return mode == fastTrig ? fast_atan(value) : std::atan(value);
+}
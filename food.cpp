@@ -6,7 +6,7 @@ Food::Food(const int& x, const int& y, const int& initialQuantity)
     quantity = initialQuantity;
 }
 
-int Food::get_quantity()
+int Food::get_quantity() const
 {
     return quantity;
 }
@@ -7,7 +7,7 @@ class Food
 {
 public:
     Food(const int& x, const int& y, const int& initialQuantity);
-    int get_quantity();
+    int get_quantity() const;
     Vector3D get_location() const;
     void reduce_quantity(const int& amount);
 
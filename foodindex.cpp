@@ -0,0 +1,155 @@
+#include "foodindex.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+FoodIndex::FoodIndex(){}
+
+FoodIndex::FoodIndex(const int& width, const int& height, const int& cellSize): cellSize(std::max(cellSize, 1))
+{
+    bucketsWide = width/this->cellSize + 1;
+    bucketsHigh = height/this->cellSize + 1;
+    buckets = std::vector<std::vector<int>>(bucketsWide*bucketsHigh);
+}
+
+int FoodIndex::size() const
+{
+    return foods.size();
+}
+
+const std::vector<Food>& FoodIndex::get_foods() const
+{
+    return foods;
+}
+
+const Food& FoodIndex::get_food(const int& index) const
+{
+    return foods[index];
+}
+
+void FoodIndex::add(const Food& food)
+{
+    Vector3D location = food.get_location();
+    int bucket = get_bucket(location[0], location[1]);
+    buckets[bucket].push_back(foods.size());
+    foodBuckets.push_back(bucket);
+    foods.push_back(food);
+}
+
+void FoodIndex::remove(const int& index)
+{
+    int last = foods.size() - 1;
+    std::vector<int>& bucket = buckets[foodBuckets[index]];
+    bucket.erase(std::find(bucket.begin(), bucket.end(), index));
+    if (index != last)
+    {
+        replace_in_bucket(foodBuckets[last], last, index);
+        foods[index] = foods[last];
+        foodBuckets[index] = foodBuckets[last];
+    }
+    foods.pop_back();
+    foodBuckets.pop_back();
+}
+
+void FoodIndex::remove_within(const double& x, const double& y, const double& radius)
+{
+    remove_near_segment(Vector3D(x, y, 0), Vector3D(x, y, 0), radius);
+}
+
+// Removes every pile closer than radius to the segment, visiting only the
+// buckets that overlap the segment's bounding box grown by the radius.
+void FoodIndex::remove_near_segment(const Vector3D& start, const Vector3D& end, const double& radius)
+{
+    int firstRow = get_bucket_row(std::min(start[1], end[1]) - radius);
+    int lastRow = get_bucket_row(std::max(start[1], end[1]) + radius);
+    int firstColumn = get_bucket_column(std::min(start[0], end[0]) - radius);
+    int lastColumn = get_bucket_column(std::max(start[0], end[0]) + radius);
+    for (int row = firstRow; row <= lastRow; row++)
+    {
+        for (int column = firstColumn; column <= lastColumn; column++)
+        {
+            std::vector<int>& bucket = buckets[row*bucketsWide + column];
+            // Removing shifts the entries after i, so walk the bucket backwards.
+            for (int i = bucket.size() - 1; i >= 0; i--)
+            {
+                int index = bucket[i];
+                if (distance_squared_to_segment(foods[index].get_location(), start, end) < radius*radius)
+                {
+                    remove(index);
+                }
+            }
+        }
+    }
+}
+
+void FoodIndex::reduce_quantity(const int& index, const int& amount)
+{
+    foods[index].reduce_quantity(amount);
+    if (foods[index].get_quantity() < 1)
+    {
+        remove(index);
+    }
+}
+
+void FoodIndex::clear()
+{
+    for (int i = 0; i < buckets.size(); i++)
+    {
+        buckets[i].clear();
+    }
+    foods.clear();
+    foodBuckets.clear();
+}
+
+// Nearest pile with |dx| < reach and |dy| < reach, or -1. Ties go to the
+// lower index so the answer does not depend on bucket order.
+int FoodIndex::find_nearest(const double& x, const double& y, const double& reach) const
+{
+    int nearest{-1};
+    double nearestDistance{0};
+    for (int row = get_bucket_row(y - reach); row <= get_bucket_row(y + reach); row++)
+    {
+        for (int column = get_bucket_column(x - reach); column <= get_bucket_column(x + reach); column++)
+        {
+            const std::vector<int>& bucket = buckets[row*bucketsWide + column];
+            for (int i = 0; i < bucket.size(); i++)
+            {
+                Vector3D location = foods[bucket[i]].get_location();
+                double dx = location[0] - x;
+                double dy = location[1] - y;
+                if (std::abs(dx) >= reach || std::abs(dy) >= reach)
+                {
+                    continue;
+                }
+                double distance = dx*dx + dy*dy;
+                if (nearest < 0 || distance < nearestDistance || (distance == nearestDistance && bucket[i] < nearest))
+                {
+                    nearest = bucket[i];
+                    nearestDistance = distance;
+                }
+            }
+        }
+    }
+    return nearest;
+}
+
+int FoodIndex::get_bucket(const double& x, const double& y) const
+{
+    return get_bucket_row(y)*bucketsWide + get_bucket_column(x);
+}
+
+int FoodIndex::get_bucket_column(const double& x) const
+{
+    return std::min(std::max(int(x)/cellSize, 0), bucketsWide - 1);
+}
+
+int FoodIndex::get_bucket_row(const double& y) const
+{
+    return std::min(std::max(int(y)/cellSize, 0), bucketsHigh - 1);
+}
+
+void FoodIndex::replace_in_bucket(const int& bucket, const int& oldIndex, const int& newIndex)
+{
+    std::vector<int>& indices = buckets[bucket];
+    *std::find(indices.begin(), indices.end(), oldIndex) = newIndex;
+}
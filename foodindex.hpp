@@ -0,0 +1,45 @@
+#ifndef FOODINDEX_HPP
+#define FOODINDEX_HPP
+
+#include "food.hpp"
+
+#include <vector>
+
+// Food piles bucketed on a uniform grid of square cells, so lookups only visit
+// the buckets overlapping the query box instead of every pile. Removing a pile
+// moves the last pile into its slot, which keeps removal cheap but does not
+// preserve the order the piles were added in.
+class FoodIndex
+{
+public:
+    FoodIndex();
+    FoodIndex(const int& width, const int& height, const int& cellSize);
+
+    int size() const;
+    const std::vector<Food>& get_foods() const;
+    const Food& get_food(const int& index) const;
+
+    void add(const Food& food);
+    void remove(const int& index);
+    void remove_within(const double& x, const double& y, const double& radius);
+    void remove_near_segment(const Vector3D& start, const Vector3D& end, const double& radius);
+    void reduce_quantity(const int& index, const int& amount);
+    void clear();
+
+    int find_nearest(const double& x, const double& y, const double& reach) const;
+
+private:
+    int get_bucket(const double& x, const double& y) const;
+    int get_bucket_column(const double& x) const;
+    int get_bucket_row(const double& y) const;
+    void replace_in_bucket(const int& bucket, const int& oldIndex, const int& newIndex);
+
+    int cellSize{1};
+    int bucketsWide{1};
+    int bucketsHigh{1};
+    std::vector<Food> foods;
+    std::vector<int> foodBuckets;
+    std::vector<std::vector<int>> buckets{1};
+};
+
+#endif // FOODINDEX_HPP
@@ -0,0 +1,314 @@
+#include "world.hpp"
+#include "randomstreams.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Runs the simulation without a window, as fast as it will go, and reports
+// throughput and where the time went. For example:
+//   AntSimHeadless --width 2000 --height 2000 --ants 20000 --random-food 50 --ticks 500 --threads 8
+
+namespace
+{
+struct FoodPile
+{
+    int x;
+    int y;
+    int quantity;
+};
+
+struct RunOptions
+{
+    int width{800};
+    int height{600};
+    int antCount{1000};
+    bool hasColonyLocation{false};
+    int colonyX{0};
+    int colonyY{0};
+    std::vector<FoodPile> foodPiles;
+    int randomFoodPiles{0};
+    int foodQuantity{500};
+    unsigned int seed{1};
+    int ticks{1000};
+    int threads{1};
+    bool fused{false};
+};
+
+void print_usage(const char* program)
+{
+    std::printf("Usage: %s [options]\n"
+                "  --width N            world width (default 800)\n"
+                "  --height N           world height (default 600)\n"
+                "  --ants N             ants placed at the colony (default 1000)\n"
+                "  --colony X,Y         colony location (default world centre)\n"
+                "  --food X,Y,Q         add a food pile; may be repeated\n"
+                "  --random-food N      add N piles at seeded random locations\n"
+                "  --food-quantity Q    quantity of each random pile (default 500)\n"
+                "  --seed N             random seed (default 1)\n"
+                "  --ticks N            updates to run (default 1000)\n"
+                "  --threads N          worker threads (default 1)\n"
+                "  --fused              use the fused update path\n",
+                program);
+}
+
+// Reads count comma-separated ints and requires the whole text to be used.
+bool parse_int_list(const char* text, int* values, const int& count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        char* end;
+        errno = 0;
+        long parsed = std::strtol(text, &end, 10);
+        if (end == text || errno == ERANGE || parsed < INT_MIN || parsed > INT_MAX)
+        {
+            return false;
+        }
+        values[i] = int(parsed);
+        if (*end != (i + 1 < count ? ',' : '\0'))
+        {
+            return false;
+        }
+        text = end + 1;
+    }
+    return true;
+}
+
+bool parse_int(const char* text, int& value)
+{
+    return parse_int_list(text, &value, 1);
+}
+
+// strtoul() accepts a sign and wraps negatives, so only plain digits pass.
+bool parse_unsigned(const char* text, unsigned int& value)
+{
+    if (*text < '0' || *text > '9')
+    {
+        return false;
+    }
+    char* end;
+    errno = 0;
+    unsigned long parsed = std::strtoul(text, &end, 10);
+    if (*end != '\0' || errno == ERANGE || parsed > UINT_MAX)
+    {
+        return false;
+    }
+    value = (unsigned int)(parsed);
+    return true;
+}
+
+bool parse_options(int argc, char* argv[], RunOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--help" || option == "-h")
+        {
+            return false;
+        }
+        if (option == "--fused")
+        {
+            options.fused = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            std::fprintf(stderr, "Missing value for %s\n", option.c_str());
+            return false;
+        }
+        const char* value = argv[++i];
+
+        bool valid{true};
+        if (option == "--width")
+        {
+            valid = parse_int(value, options.width) && options.width > 10;
+        }
+        else if (option == "--height")
+        {
+            valid = parse_int(value, options.height) && options.height > 10;
+        }
+        else if (option == "--ants")
+        {
+            valid = parse_int(value, options.antCount) && options.antCount >= 0;
+        }
+        else if (option == "--colony")
+        {
+            int location[2];
+            valid = parse_int_list(value, location, 2);
+            options.hasColonyLocation = valid;
+            options.colonyX = location[0];
+            options.colonyY = location[1];
+        }
+        else if (option == "--food")
+        {
+            int pile[3];
+            valid = parse_int_list(value, pile, 3);
+            if (valid)
+            {
+                options.foodPiles.push_back(FoodPile{pile[0], pile[1], pile[2]});
+            }
+        }
+        else if (option == "--random-food")
+        {
+            valid = parse_int(value, options.randomFoodPiles) && options.randomFoodPiles >= 0;
+        }
+        else if (option == "--food-quantity")
+        {
+            valid = parse_int(value, options.foodQuantity) && options.foodQuantity > 0;
+        }
+        else if (option == "--seed")
+        {
+            valid = parse_unsigned(value, options.seed);
+        }
+        else if (option == "--ticks")
+        {
+            valid = parse_int(value, options.ticks) && options.ticks > 0;
+        }
+        else if (option == "--threads")
+        {
+            valid = parse_int(value, options.threads) && options.threads > 0;
+        }
+        else
+        {
+            std::fprintf(stderr, "Unknown option %s\n", option.c_str());
+            return false;
+        }
+
+        if (!valid)
+        {
+            std::fprintf(stderr, "Invalid value for %s: %s\n", option.c_str(), value);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Ants deposit up to pheromoneSpread cells around themselves, so the colony
+// has to sit that far inside the border walls.
+bool place_colony(const World& world, RunOptions& options)
+{
+    if (!options.hasColonyLocation)
+    {
+        options.colonyX = options.width/2;
+        options.colonyY = options.height/2;
+    }
+    int margin = world.view_obstacles().get_border_width() + world.get_pheromone_spread();
+    if (options.colonyX < margin || options.colonyX > options.width - margin ||
+        options.colonyY < margin || options.colonyY > options.height - margin)
+    {
+        std::fprintf(stderr, "Colony %d,%d must be at least %d cells inside the %dx%d world\n",
+                     options.colonyX, options.colonyY, margin, options.width, options.height);
+        return false;
+    }
+    return true;
+}
+
+void build_world(World& world, const RunOptions& options)
+{
+    world.set_random_seed(options.seed);
+    world.set_thread_count(options.threads);
+    world.set_update_mode(options.fused ? fusedUpdate : phasedUpdate);
+
+    world.add_colony(options.colonyX, options.colonyY, options.antCount);
+
+    for (int i = 0; i < options.foodPiles.size(); i++)
+    {
+        world.add_food(options.foodPiles[i].x, options.foodPiles[i].y, options.foodPiles[i].quantity);
+    }
+
+    PcgStream stream{options.seed, 7};
+    for (int i = 0; i < options.randomFoodPiles; i++)
+    {
+        int x = int(stream.next_double(10, options.width - 10));
+        int y = int(stream.next_double(10, options.height - 10));
+        world.add_food(x, y, options.foodQuantity);
+    }
+}
+}
+
+int main(int argc, char* argv[])
+{
+    RunOptions options;
+    if (!parse_options(argc, argv, options))
+    {
+        print_usage(argv[0]);
+        return argc > 1 && (std::strcmp(argv[1], "--help") == 0 || std::strcmp(argv[1], "-h") == 0) ? 0 : 1;
+    }
+
+    World world{options.width, options.height};
+    if (!place_colony(world, options))
+    {
+        return 1;
+    }
+    build_world(world, options);
+    int foodPiles = world.view_food().size();
+    int requestedFoodPiles = int(options.foodPiles.size()) + options.randomFoodPiles;
+    if (foodPiles < requestedFoodPiles)
+    {
+        std::fprintf(stderr, "%d of %d food piles were outside the world and dropped\n",
+                     requestedFoodPiles - foodPiles, requestedFoodPiles);
+    }
+    int startingAnts = world.get_ant_count();
+
+    typedef std::chrono::steady_clock Clock;
+    std::vector<double> phaseSeconds(updatePhaseCount, 0);
+    long long antUpdates{0};
+    Clock::time_point runStart = Clock::now();
+    for (int tick = 0; tick < options.ticks; tick++)
+    {
+        if (options.fused)
+        {
+            // The fused pass has no per-phase boundaries to time from here,
+            // so take the split the World records, if it was built to.
+            world.update();
+#ifdef ANTSIM_STATS
+            SimulationStats tickStats = world.stats();
+            for (int phase = 0; phase < updatePhaseCount; phase++)
+            {
+                phaseSeconds[phase] += tickStats.lastPhaseMilliseconds[phase]/1000;
+            }
+#endif
+        }
+        else
+        {
+            for (int phase = 0; phase < updatePhaseCount; phase++)
+            {
+                Clock::time_point phaseStart = Clock::now();
+                world.run_phase(UpdatePhase(phase));
+                phaseSeconds[phase] += std::chrono::duration<double>(Clock::now() - phaseStart).count();
+            }
+        }
+        antUpdates += world.get_ant_count();
+    }
+    double totalSeconds = std::chrono::duration<double>(Clock::now() - runStart).count();
+
+    std::printf("world %dx%d, %d ants, %d food piles, seed %u, %d threads, %s update\n",
+                options.width, options.height, startingAnts, foodPiles,
+                options.seed, options.threads, options.fused ? "fused" : "phased");
+    std::printf("%d ticks in %.3f s\n", options.ticks, totalSeconds);
+    std::printf("%.1f ticks/s\n", options.ticks/totalSeconds);
+    std::printf("%.3e ant-updates/s\n", antUpdates/totalSeconds);
+    std::printf("\n%-10s %12s %12s %8s\n", "phase", "total ms", "ms/tick", "share");
+    for (int phase = 0; phase < updatePhaseCount; phase++)
+    {
+        std::printf("%-10s %12.2f %12.4f %7.1f%%\n", get_update_phase_name(UpdatePhase(phase)),
+                    1000*phaseSeconds[phase], 1000*phaseSeconds[phase]/options.ticks, 100*phaseSeconds[phase]/totalSeconds);
+    }
+
+#ifdef ANTSIM_STATS
+    SimulationStats stats = world.stats();
+    std::printf("\n%-18s %14s %14s\n", "counter", "total", "per tick");
+    for (int counter = 0; counter < statCounterCount; counter++)
+    {
+        std::printf("%-18s %14lld %14.1f\n", get_stat_counter_name(StatCounter(counter)),
+                    stats.totalCounters[counter], double(stats.totalCounters[counter])/stats.ticks);
+    }
+#endif
+    std::printf("\nstate hash %016llx\n", (unsigned long long)world.get_state_hash());
+    return 0;
+}
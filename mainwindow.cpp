@@ -6,31 +6,38 @@ MainWindow::MainWindow(QWidget *parent) :QMainWindow{parent}, mMainWindowUI{new
     mMainWindowUI->setupUi(this);
     resize(1100, worldHeight+50);
 
-    QTimer *timer = new QTimer(this);
-    connect(timer, SIGNAL(timeout()), this, SLOT(update()));
-    timer->start(10);
-
-    renderArea = new RenderArea(this, &world);
+    renderArea = new RenderArea(this, &simulation);
     QGridLayout *gridLayout = new QGridLayout(this->mMainWindowUI->graphicsFrame);
     gridLayout->addWidget(renderArea,0,0);
+
+    // Repaints only pick up the newest snapshot; the simulation ticks on its
+    // own thread at its own rate.
+    QTimer *timer = new QTimer(this);
+    connect(timer, SIGNAL(timeout()), renderArea, SLOT(update()));
+    timer->start(16);
+
+    QTimer *statusUpdateTimer = new QTimer(this);
+    connect(statusUpdateTimer, SIGNAL(timeout()), this, SLOT(update_clock_status()));
+    statusUpdateTimer->start(250);
+    statusTimer.start();
+
+    simulation.get_clock().set_target_ticks_per_second(mMainWindowUI->ticksPerSecondSpinBox->value());
+    simulation.start();
 }
 
 MainWindow::~MainWindow()
 {
+    simulation.stop();
     delete mMainWindowUI;
 }
 
-void MainWindow::paintEvent(QPaintEvent *)
-{
-    world.update();
-    renderArea->update();
-}
-
 void MainWindow::on_generateMapPushButton_clicked()
 {
-    world.clear_all();
-    world.generate_random_caves();
-    renderArea->generate_obstacle_image_vector();
+    simulation.post([](World& world)
+    {
+        world.clear_all();
+        world.generate_random_caves();
+    });
 }
 
 void MainWindow::on_addAntPushButton_clicked()
@@ -65,7 +72,36 @@ void MainWindow::on_addColonyPushButton_clicked()
 
 void MainWindow::on_clearMapPushButton_clicked()
 {
-    world.clear_all();
-    renderArea->generate_obstacle_image_vector();
+    simulation.post([](World& world) { world.clear_all(); });
 }
 
+void MainWindow::on_ticksPerSecondSpinBox_valueChanged(int ticksPerSecond)
+{
+    simulation.get_clock().set_target_ticks_per_second(ticksPerSecond);
+}
+
+void MainWindow::on_turboCheckBox_toggled(bool checked)
+{
+    simulation.get_clock().set_turbo(checked);
+}
+
+void MainWindow::on_fastForwardPushButton_clicked()
+{
+    simulation.get_clock().fast_forward(mMainWindowUI->fastForwardSpinBox->value());
+}
+
+void MainWindow::update_clock_status()
+{
+    long long ticks = simulation.get_tick_count();
+    double seconds = statusTimer.restart()/1000.0;
+    double ticksPerSecond = seconds > 0 ? (ticks - statusTicks)/seconds : 0;
+    statusTicks = ticks;
+
+    QString status = QString("Tick %1\n%2 ticks/s").arg(ticks).arg(ticksPerSecond, 0, 'f', 0);
+    long long remaining = simulation.get_clock().get_fast_forward_remaining();
+    if (remaining > 0)
+    {
+        status += QString("\nFast-forward: %1 left").arg(remaining);
+    }
+    mMainWindowUI->clockStatusLabel->setText(status);
+}
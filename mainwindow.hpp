@@ -1,13 +1,14 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
-#include "world.hpp"
+#include "simulationworker.hpp"
 #include "renderarea.hpp"
 
 #include <QMainWindow>
 #include <QtCore>
 #include <QPainter>
 #include <QMouseEvent>
+#include <QElapsedTimer>
 
 namespace Ui {class MainWindowForm;}
 
@@ -19,8 +20,6 @@ public:
     explicit MainWindow(QWidget *parent = 0);
     ~MainWindow();
 
-    virtual void paintEvent(QPaintEvent *);
-
 public slots:
 
 private slots:
@@ -38,13 +37,23 @@ private slots:
 
     void on_clearMapPushButton_clicked();
 
+    void on_ticksPerSecondSpinBox_valueChanged(int ticksPerSecond);
+
+    void on_turboCheckBox_toggled(bool checked);
+
+    void on_fastForwardPushButton_clicked();
+
+    void update_clock_status();
+
 private:
     Ui::MainWindowForm *mMainWindowUI;
     int currentAddObject{1};
     int worldWidth{800};
     int worldHeight{500};
-    World world{worldWidth, worldHeight};
+    SimulationWorker simulation{worldWidth, worldHeight};
     RenderArea* renderArea;
+    long long statusTicks{0};
+    QElapsedTimer statusTimer;
 };
 
 #endif // MAINWINDOW_H
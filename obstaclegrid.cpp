@@ -1,25 +1,86 @@
 #include "obstaclegrid.hpp"
+#include "simstats.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <math.h>
 #include <random>
 
+namespace
+{
+inline int count_bits(std::uint64_t bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(bits);
+#else
+    int count = 0;
+    for (; bits != 0; bits &= bits - 1)
+    {
+        count++;
+    }
+    return count;
+#endif
+}
+
+inline int lowest_bit(const std::uint64_t& bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(bits);
+#else
+    int bit = 0;
+    while (((bits >> bit) & 1) == 0)
+    {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+inline int highest_bit(const std::uint64_t& bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(bits);
+#else
+    int bit = 63;
+    while (((bits >> bit) & 1) == 0)
+    {
+        bit--;
+    }
+    return bit;
+#endif
+}
+
+// Bits firstBit to lastBit inclusive, both in [0,63].
+inline std::uint64_t bit_span(const int& firstBit, const int& lastBit)
+{
+    return (~std::uint64_t(0) >> (63 - lastBit)) & (~std::uint64_t(0) << firstBit);
+}
+
+inline int rounded_cell(const double& value)
+{
+    return int(value + .5);
+}
+}
+
+const int ObstacleGrid::maxClearance = 255;
+
 ObstacleGrid::ObstacleGrid(){}
 
 ObstacleGrid::ObstacleGrid(const int& width, const int& height): worldWidth(width),worldHeight(height)
 {
     gridWidth = width + 1;
     gridHeight = height + 1;
-    obstacles = std::vector<bool>((gridWidth)*(gridHeight));
-    fill(obstacles.begin(), obstacles.end(), false);
+    wordsPerRow = (gridWidth + 63)/64;
+    obstacleWords = std::vector<std::uint64_t>(wordsPerRow*gridHeight, 0);
+    mark_dirty(0, 0, gridWidth, gridHeight);
 }
 
-int ObstacleGrid::get_width()
+int ObstacleGrid::get_width() const
 {
     return worldWidth;
 }
 
-int ObstacleGrid::get_height()
+int ObstacleGrid::get_height() const
 {
     return worldHeight;
 }
@@ -41,11 +102,14 @@ Vector3D ObstacleGrid::get_location(const int& index)
 std::vector<Vector3D> ObstacleGrid::get_obstacle_locations()
 {
     std::vector<Vector3D> obstacleLocations;
-    for (int i = 0; i < obstacles.size(); i++)
+    for (int row = 0; row < gridHeight; row++)
     {
-        if (obstacles[i] == true)
+        for (int word = 0; word < wordsPerRow; word++)
         {
-            obstacleLocations.push_back(get_location(i));
+            for (std::uint64_t bits = obstacleWords[row*wordsPerRow + word]; bits != 0; bits &= bits - 1)
+            {
+                obstacleLocations.push_back(Vector3D(64*word + lowest_bit(bits), row, 0));
+            }
         }
     }
     return obstacleLocations;
@@ -53,9 +117,45 @@ std::vector<Vector3D> ObstacleGrid::get_obstacle_locations()
 
 std::vector<bool> ObstacleGrid::get_obstacle_vector()
 {
+    std::vector<bool> obstacles(gridWidth*gridHeight, false);
+    for (int row = 0; row < gridHeight; row++)
+    {
+        for (int word = 0; word < wordsPerRow; word++)
+        {
+            for (std::uint64_t bits = obstacleWords[row*wordsPerRow + word]; bits != 0; bits &= bits - 1)
+            {
+                obstacles[row*gridWidth + 64*word + lowest_bit(bits)] = true;
+            }
+        }
+    }
     return obstacles;
 }
 
+const std::vector<std::uint64_t>& ObstacleGrid::get_obstacle_words() const
+{
+    return obstacleWords;
+}
+
+int ObstacleGrid::get_words_per_row() const
+{
+    return wordsPerRow;
+}
+
+int ObstacleGrid::get_border_width() const
+{
+    return borderWidth;
+}
+
+TrigMode ObstacleGrid::get_trig_mode()
+{
+    return trigMode;
+}
+
+void ObstacleGrid::set_trig_mode(const TrigMode& mode)
+{
+    trigMode = mode;
+}
+
 void ObstacleGrid::add_obstacle_line(const int &x1, const int &y1, const int &x2, const int &y2, const int &thickness)
 {
 
@@ -134,7 +234,13 @@ void ObstacleGrid::add_obstacle_circle(const int &originX, const int &originY, c
 
 void ObstacleGrid::generate_random_caves()
 {
-    randomly_fill_map(caveFillPercent);
+    PcgStream stream{std::random_device{}(), 0};
+    generate_random_caves(stream);
+}
+
+void ObstacleGrid::generate_random_caves(PcgStream& stream)
+{
+    randomly_fill_map(caveFillPercent, stream);
     fill_borders();
     for (int i = 0; i < smoothIterations; i++)
     {
@@ -143,14 +249,20 @@ void ObstacleGrid::generate_random_caves()
 }
 
 void ObstacleGrid::randomly_fill_map(const int &fillPercent)
+{
+    PcgStream stream{std::random_device{}(), 0};
+    randomly_fill_map(fillPercent, stream);
+}
+
+void ObstacleGrid::randomly_fill_map(const int& fillPercent, PcgStream& stream)
 {
     clear();
     for (int x = 0; x < gridWidth-randomSquareSize; x = x+randomSquareSize)
     {
         for (int y = 0; y < gridHeight-randomSquareSize; y = y+randomSquareSize)
         {
-            double rand = generate_random_percent();
-            if (rand < caveFillPercent)
+            double rand = stream.next_double(0, 100);
+            if (rand < fillPercent)
             {
                 fill_square(x,y);
             }
@@ -160,7 +272,7 @@ void ObstacleGrid::randomly_fill_map(const int &fillPercent)
 
 void ObstacleGrid::smooth()
 {
-    std::vector<bool> obstacleCopy = obstacles;
+    std::vector<std::uint64_t> obstacleCopy = obstacleWords;
     for (int x = 0; x < gridWidth-randomSquareSize; x = x+randomSquareSize)
     {
         for (int y = 0; y < gridHeight-randomSquareSize; y = y+randomSquareSize)
@@ -178,25 +290,33 @@ void ObstacleGrid::smooth()
     }
 }
 
-double ObstacleGrid::get_neighbor_wall_count(const int &x, const int &y, const std::vector<bool>& obstacleCopy)
+// The neighbours sit every randomSquareSize cells, so one row of them is read
+// as a single window of bits and counted against a sampling mask. This needs
+// 4*randomSquareSize + 1 <= 64.
+double ObstacleGrid::get_neighbor_wall_count(const int &x, const int &y, const std::vector<std::uint64_t>& obstacleWordsCopy)
 {
+    int windowWidth = 4*randomSquareSize + 1;
+    std::uint64_t sampleMask{0};
+    for (int i = 0; i < 5; i++)
+    {
+        sampleMask |= std::uint64_t(1) << (i*randomSquareSize);
+    }
+
     double wallCount = 0;
-    for (int neighbourX = x - 2*randomSquareSize; neighbourX <= x + 2*randomSquareSize; neighbourX+=randomSquareSize)
+    for (int neighbourY = y - 2*randomSquareSize; neighbourY <= y + 2*randomSquareSize; neighbourY+=randomSquareSize)
     {
-        for (int neighbourY = y - 2*randomSquareSize; neighbourY <= y + 2*randomSquareSize; neighbourY+=randomSquareSize)
+        if (neighbourY >= 0 && neighbourY < gridHeight)
         {
-            if (neighbourX >= 0 && neighbourX < gridWidth && neighbourY >= 0 && neighbourY < gridHeight)
+            std::uint64_t window = get_row_bits(obstacleWordsCopy, neighbourY, x - 2*randomSquareSize, windowWidth);
+            if (neighbourY == y)
             {
-                if (neighbourX != x || neighbourY != y)
-                {
-                    int index = get_index(neighbourX,neighbourY);
-                    wallCount += obstacleCopy[index];
-                }
-            }
-            else
-            {
-                wallCount++;
+                window &= ~(std::uint64_t(1) << (2*randomSquareSize));
             }
+            wallCount += count_bits(window & sampleMask);
+        }
+        else
+        {
+            wallCount += 5;
         }
     }
     return wallCount;
@@ -204,23 +324,17 @@ double ObstacleGrid::get_neighbor_wall_count(const int &x, const int &y, const s
 
 void ObstacleGrid::fill_square(const int &x, const int &y)
 {
-    for (int i = 0; i < randomSquareSize; i++)
+    for (int j = 0; j < randomSquareSize; j++)
     {
-        for (int j = 0; j < randomSquareSize; j++)
-        {
-            add_obstacle(x+i, y+j);
-        }
+        set_row_span(y+j, x, x + randomSquareSize - 1, true);
     }
 }
 
 void ObstacleGrid::unfill_square(const int &x, const int &y)
 {
-    for (int i = 0; i < randomSquareSize; i++)
+    for (int j = 0; j < randomSquareSize; j++)
     {
-        for (int j = 0; j < randomSquareSize; j++)
-        {
-            remove_obstacle(x+i, y+j);
-        }
+        set_row_span(y+j, x, x + randomSquareSize - 1, false);
     }
 }
 
@@ -251,96 +365,639 @@ void ObstacleGrid::erase(const int &originX, const int &originY, const double &r
 
 void ObstacleGrid::clear()
 {
-    for (int i = 0; i < obstacles.size(); i++)
-    {
-        obstacles[i] = false;
-    }
+    fill(obstacleWords.begin(), obstacleWords.end(), 0);
+    mark_dirty(0, 0, gridWidth, gridHeight);
     fill_borders();
 }
 
 bool ObstacleGrid::check_obstacle(const double& x, const double& y) const
 {
-    int index = get_index(x,y);
-    return obstacles[index];
+    return is_blocked(rounded_cell(x), rounded_cell(y));
+}
+
+bool ObstacleGrid::is_blocked(const int& column, const int& row) const
+{
+    if (column < 0 || column >= gridWidth || row < 0 || row >= gridHeight)
+    {
+        return true;
+    }
+    return (obstacleWords[row*wordsPerRow + (column >> 6)] >> (column & 63)) & 1;
 }
 
 bool ObstacleGrid::check_for_obstacle_front(const Vector3D& locationVector, const double& orientation, const int& detectionRange) const
 {
-    Vector3D orientationVector{cos(orientation),sin(orientation),0};
-    bool obstacleInFront{false};
-    int timestep = 0;
+    return probe_ray(locationVector, orientation, detectionRange) <= detectionRange;
+}
+
+int ObstacleGrid::check_obstacle_distance(const Vector3D& locationVector, const double& orientation, const int& detectionRange) const
+{
+    return std::min(probe_ray(locationVector, orientation, detectionRange), detectionRange);
+}
 
-    while (obstacleInFront==false && timestep <= detectionRange)
+// The front ray decides whether the side rays are needed at all, so one call
+// covers what an ant asks before turning away from a wall.
+bool ObstacleGrid::cast_avoidance_rays(const Vector3D& locationVector, const double& orientation, const double& turnAngle, const int& detectionRange, int& rightDistance, int& leftDistance) const
+{
+    if (probe_ray(locationVector, orientation, detectionRange) > detectionRange)
     {
-        double x{locationVector[0]+timestep*orientationVector[0]};
-        double y{locationVector[1]+timestep*orientationVector[1]};
+        return false;
+    }
+    rightDistance = std::min(probe_ray(locationVector, orientation + turnAngle, detectionRange), detectionRange);
+    leftDistance = std::min(probe_ray(locationVector, orientation - turnAngle, detectionRange), detectionRange);
+    return true;
+}
+
+RaycastMode ObstacleGrid::get_raycast_mode() const
+{
+    return raycastMode;
+}
+
+void ObstacleGrid::set_raycast_mode(const RaycastMode& mode)
+{
+    raycastMode = mode;
+}
+
+// Distance in whole cells to the first blocked cell, or detectionRange + 1.
+int ObstacleGrid::probe_ray(const Vector3D& locationVector, const double& orientation, const int& detectionRange) const
+{
+    if (raycastMode == steppedRaycast)
+    {
+        return march_ray(locationVector, orientation, detectionRange);
+    }
+    RayHit hit = cast_ray(locationVector, orientation, detectionRange);
+    return hit.blocked ? int(hit.distance) : detectionRange + 1;
+}
+
+// Cell (c, r) covers [c - .5, c + .5) x [r - .5, r + .5), matching the
+// rounding used everywhere else. Each iteration crosses into the neighbouring
+// cell whose boundary the ray reaches first. With a current distance field the
+// ray first jumps over open ground: every point within clearance - sqrt(2) of
+// a cell's point lies in a cell no closer than the clearance allows.
+RayHit ObstacleGrid::cast_ray(const Vector3D& locationVector, const double& orientation, const int& detectionRange) const
+{
+    const double roundingMargin = 1.4143;
+    const double minimumSkip = 8;
+    const double never = 1e30;
+    double sine, cosine;
+    trig_sin_cos(trigMode, orientation, sine, cosine);
+    int columnStep = cosine > 0 ? 1 : -1;
+    int rowStep = sine > 0 ? 1 : -1;
+    double columnDelta = cosine != 0 ? 1/std::fabs(cosine) : never;
+    double rowDelta = sine != 0 ? 1/std::fabs(sine) : never;
+    bool skipping = is_distance_field_current();
+
+    double distance{0};
+    bool restart{true};
+    int column{0};
+    int row{0};
+    double nextColumnDistance{0};
+    double nextRowDistance{0};
+    int steps{0};
+    while (distance <= detectionRange)
+    {
+        steps++;
+        if (restart)
+        {
+            double x = locationVector[0] + distance*cosine + .5;
+            double y = locationVector[1] + distance*sine + .5;
+            column = int(std::floor(x));
+            row = int(std::floor(y));
+            nextColumnDistance = cosine > 0 ? distance + (column + 1 - x)*columnDelta : cosine < 0 ? distance + (x - column)*columnDelta : never;
+            nextRowDistance = sine > 0 ? distance + (row + 1 - y)*rowDelta : sine < 0 ? distance + (y - row)*rowDelta : never;
+            restart = false;
+        }
+
+        if (is_blocked(column, row))
+        {
+            ANTSIM_COUNT(rayCellTestsCounter, steps);
+            return RayHit{true, distance, column, row};
+        }
+        if (skipping)
+        {
+            double clearance = clearances[row*gridWidth + column];
+            if (clearance >= roundingMargin + minimumSkip)
+            {
+                distance += clearance - roundingMargin;
+                restart = true;
+                continue;
+            }
+        }
 
-        if (check_obstacle(x,y))
+        if (nextColumnDistance < nextRowDistance)
         {
-            obstacleInFront = true;
+            distance = nextColumnDistance;
+            nextColumnDistance += columnDelta;
+            column += columnStep;
+        }
+        else
+        {
+            distance = nextRowDistance;
+            nextRowDistance += rowDelta;
+            row += rowStep;
         }
-        timestep++;
     }
-    return obstacleInFront;
+    ANTSIM_COUNT(rayCellTestsCounter, steps);
+    return RayHit{false, double(detectionRange), column, row};
 }
 
-int ObstacleGrid::check_obstacle_distance(const Vector3D& locationVector, const double& orientation, const int& detectionRange) const
+// Returns the first whole step along the ray whose rounded cell is blocked,
+// or detectionRange + 1 if there is none. Rays closer to horizontal than
+// vertical advance at most one column per step, so every run of steps that
+// stays in one row covers a contiguous span of columns and is checked a word
+// at a time. Steeper rays test one bit per step.
+int ObstacleGrid::march_ray(const Vector3D& locationVector, const double& orientation, const int& detectionRange) const
 {
-    bool obstacle{false};
-    int distanceForward{0};
+    double sine, cosine;
+    trig_sin_cos(trigMode, orientation, sine, cosine);
+    Vector3D orientationVector{cosine,sine,0};
+    double startX = locationVector[0];
+    double startY = locationVector[1];
+    double stepX = orientationVector[0];
+    double stepY = orientationVector[1];
+
+    int firstStep{0};
+    if (is_distance_field_current())
+    {
+        firstStep = skip_clear_steps(startX, startY, stepX, stepY, detectionRange);
+    }
 
-    Vector3D orientationVector{cos(orientation),sin(orientation),0};
+    if (std::fabs(stepX) < std::fabs(stepY))
+    {
+        for (int step = firstStep; step <= detectionRange; step++)
+        {
+            if (is_blocked(rounded_cell(startX + step*stepX), rounded_cell(startY + step*stepY)))
+            {
+                ANTSIM_COUNT(rayCellTestsCounter, step - firstStep + 1);
+                return step;
+            }
+        }
+        ANTSIM_COUNT(rayCellTestsCounter, std::max(detectionRange + 1 - firstStep, 0));
+        return detectionRange + 1;
+    }
 
-    while (obstacle == false && distanceForward <= detectionRange)
+    int scans{0};
+    int cellTests{0};
+    int runStart = firstStep;
+    while (runStart <= detectionRange)
     {
-        double x{locationVector[0]+distanceForward*orientationVector[0]};
-        double y{locationVector[1]+distanceForward*orientationVector[1]};
+        int row = rounded_cell(startY + runStart*stepY);
+        int low = runStart;
+        int high = detectionRange;
+        while (low < high)
+        {
+            int middle = (low + high + 1)/2;
+            if (rounded_cell(startY + middle*stepY) == row)
+            {
+                low = middle;
+            }
+            else
+            {
+                high = middle - 1;
+            }
+        }
+        int runEnd = low;
+        int lastColumn = rounded_cell(startX + runEnd*stepX);
 
-        if (check_obstacle(x,y))
+        int step = runStart;
+        int hitColumn;
+        while (step <= runEnd)
         {
-            obstacle = true;
+            scans++;
+            if (!find_obstacle_in_row(row, rounded_cell(startX + step*stepX), lastColumn, hitColumn))
+            {
+                break;
+            }
+            // First step of the run that reaches the blocked column.
+            int first = step;
+            int last = runEnd;
+            while (first < last)
+            {
+                int middle = (first + last)/2;
+                int column = rounded_cell(startX + middle*stepX);
+                if (stepX >= 0 ? column >= hitColumn : column <= hitColumn)
+                {
+                    last = middle;
+                }
+                else
+                {
+                    first = middle + 1;
+                }
+            }
+            cellTests++;
+            if (is_blocked(rounded_cell(startX + first*stepX), row))
+            {
+                ANTSIM_COUNT(rayRowScansCounter, scans);
+                ANTSIM_COUNT(rayCellTestsCounter, cellTests);
+                return first;
+            }
+            step = first + 1;
         }
-        distanceForward++;
+        runStart = runEnd + 1;
+    }
+    ANTSIM_COUNT(rayRowScansCounter, scans);
+    ANTSIM_COUNT(rayCellTestsCounter, cellTests);
+    return detectionRange + 1;
+}
+
+// Sphere tracing. A sample's rounded cell is within sqrt(2)/2 of the sample
+// in each direction, so the cell k steps ahead is at most k + sqrt(2) from the
+// current cell and cannot be blocked while k + sqrt(2) < clearance. Returns
+// the first step the clearance cannot vouch for; near walls the word scan is
+// cheaper than stepping through small clearances, so it takes over there.
+int ObstacleGrid::skip_clear_steps(const double& startX, const double& startY, const double& stepX, const double& stepY, const int& detectionRange) const
+{
+    const double roundingMargin = 1.4143;
+    const double minimumSkip = 8;
+    int step = 0;
+    int skips = 0;
+    while (step <= detectionRange)
+    {
+        skips++;
+        int column = rounded_cell(startX + step*stepX);
+        int row = rounded_cell(startY + step*stepY);
+        if (is_blocked(column, row) || clearances[row*gridWidth + column] < roundingMargin + minimumSkip)
+        {
+            ANTSIM_COUNT(rayCellTestsCounter, skips);
+            return step;
+        }
+        step += int(std::ceil(clearances[row*gridWidth + column] - roundingMargin));
+    }
+    ANTSIM_COUNT(rayCellTestsCounter, skips);
+    return step;
+}
+
+// Finds the first blocked column walking from fromColumn to toColumn
+// inclusive, in whichever direction that is.
+bool ObstacleGrid::find_obstacle_in_row(const int& row, const int& fromColumn, const int& toColumn, int& hitColumn) const
+{
+    if (row < 0 || row >= gridHeight)
+    {
+        hitColumn = fromColumn;
+        return true;
+    }
+    const std::uint64_t* rowWords = obstacleWords.data() + row*wordsPerRow;
+
+    if (fromColumn <= toColumn)
+    {
+        if (fromColumn < 0)
+        {
+            hitColumn = fromColumn;
+            return true;
+        }
+        int lastColumn = std::min(toColumn, gridWidth - 1);
+        for (int word = fromColumn >> 6; word <= lastColumn >> 6 && fromColumn <= lastColumn; word++)
+        {
+            int firstBit = word == fromColumn >> 6 ? fromColumn & 63 : 0;
+            int lastBit = word == lastColumn >> 6 ? lastColumn & 63 : 63;
+            std::uint64_t bits = rowWords[word] & bit_span(firstBit, lastBit);
+            if (bits != 0)
+            {
+                hitColumn = 64*word + lowest_bit(bits);
+                return true;
+            }
+        }
+        if (toColumn >= gridWidth)
+        {
+            hitColumn = gridWidth;
+            return true;
+        }
+        return false;
+    }
+
+    if (fromColumn >= gridWidth)
+    {
+        hitColumn = fromColumn;
+        return true;
+    }
+    int firstColumn = std::max(toColumn, 0);
+    for (int word = fromColumn >> 6; word >= firstColumn >> 6 && firstColumn <= fromColumn; word--)
+    {
+        int firstBit = word == firstColumn >> 6 ? firstColumn & 63 : 0;
+        int lastBit = word == fromColumn >> 6 ? fromColumn & 63 : 63;
+        std::uint64_t bits = rowWords[word] & bit_span(firstBit, lastBit);
+        if (bits != 0)
+        {
+            hitColumn = 64*word + highest_bit(bits);
+            return true;
+        }
+    }
+    if (toColumn < 0)
+    {
+        hitColumn = -1;
+        return true;
+    }
+    return false;
+}
+
+// Bits outside the grid read as obstacles. Needs count <= 64.
+std::uint64_t ObstacleGrid::get_row_bits(const std::vector<std::uint64_t>& words, const int& row, const int& firstColumn, const int& count) const
+{
+    if (firstColumn >= 0 && firstColumn + count <= gridWidth)
+    {
+        const std::uint64_t* rowWords = words.data() + row*wordsPerRow;
+        int word = firstColumn >> 6;
+        int shift = firstColumn & 63;
+        std::uint64_t bits = rowWords[word] >> shift;
+        if (shift + count > 64)
+        {
+            bits |= rowWords[word + 1] << (64 - shift);
+        }
+        return count == 64 ? bits : bits & ((std::uint64_t(1) << count) - 1);
+    }
+
+    std::uint64_t bits{0};
+    for (int i = 0; i < count; i++)
+    {
+        int column = firstColumn + i;
+        if (column < 0 || column >= gridWidth || (words[row*wordsPerRow + (column >> 6)] >> (column & 63)) & 1)
+        {
+            bits |= std::uint64_t(1) << i;
+        }
+    }
+    return bits;
+}
+
+void ObstacleGrid::set_row_span(const int& row, const int& firstColumn, const int& lastColumn, const bool& filled)
+{
+    int first = std::max(firstColumn, 0);
+    int last = std::min(lastColumn, gridWidth - 1);
+    if (row < 0 || row >= gridHeight || first > last)
+    {
+        return;
+    }
+
+    mark_dirty(first, row, last + 1, row + 1);
+    std::uint64_t* rowWords = obstacleWords.data() + row*wordsPerRow;
+    for (int word = first >> 6; word <= last >> 6; word++)
+    {
+        int firstBit = word == first >> 6 ? first & 63 : 0;
+        int lastBit = word == last >> 6 ? last & 63 : 63;
+        std::uint64_t mask = bit_span(firstBit, lastBit);
+        rowWords[word] = filled ? rowWords[word] | mask : rowWords[word] & ~mask;
     }
-    return distanceForward - 1;
 }
 
 void ObstacleGrid::add_obstacle(const int& x, const int& y)
 {
-    int index = get_index(x,y);
-    obstacles[index] = true;
+    set_row_span(y, x, x, true);
 }
 
 void ObstacleGrid::remove_obstacle(const int& x, const int& y)
 {
-    int index = get_index(x,y);
-    obstacles[index] = false;
+    set_row_span(y, x, x, false);
 }
 
 void ObstacleGrid::fill_borders()
 {
-    for (int x = 0; x <= worldWidth; x++)
+    for (int i = 0; i < borderWidth; i++)
+    {
+        set_row_span(i, 0, worldWidth, true);
+        set_row_span(worldHeight-i, 0, worldWidth, true);
+    }
+    for (int y = 0; y <= worldHeight; y++)
+    {
+        set_row_span(y, 0, borderWidth - 1, true);
+        set_row_span(y, worldWidth - borderWidth + 1, worldWidth, true);
+    }
+}
+
+bool ObstacleGrid::is_distance_field_enabled() const
+{
+    return distanceFieldEnabled;
+}
+
+void ObstacleGrid::set_distance_field_enabled(const bool& enabled)
+{
+    distanceFieldEnabled = enabled;
+    if (enabled)
+    {
+        build_distance_field();
+    }
+    else
+    {
+        clearances.clear();
+        mark_dirty(0, 0, gridWidth, gridHeight);
+    }
+}
+
+bool ObstacleGrid::is_distance_field_current() const
+{
+    return distanceFieldEnabled && !hasDirtyRegion;
+}
+
+int ObstacleGrid::get_clearance(const int& column, const int& row) const
+{
+    if (is_blocked(column, row))
+    {
+        return 0;
+    }
+    return clearances[row*gridWidth + column];
+}
+
+int ObstacleGrid::get_clearance_limit() const
+{
+    return clearanceLimit;
+}
+
+// Every stored clearance was capped at the old limit, so the field is rebuilt.
+void ObstacleGrid::set_clearance_limit(const int& limit)
+{
+    int newLimit = std::max(1, std::min(limit, maxClearance));
+    if (newLimit == clearanceLimit)
+    {
+        return;
+    }
+    clearanceLimit = newLimit;
+    clearances.clear();
+    mark_dirty(0, 0, gridWidth, gridHeight);
+    if (distanceFieldEnabled)
+    {
+        build_distance_field();
+    }
+}
+
+void ObstacleGrid::build_distance_field()
+{
+    prepare_distance_field();
+    int first, last;
+    get_distance_update_columns(first, last);
+    build_distance_columns(first, last);
+    get_distance_update_rows(first, last);
+    build_distance_rows(first, last);
+    finish_distance_field();
+}
+
+// Picks the update window. The target region (whose clearances are rewritten)
+// is the dirty region grown by the reach of a clearance; the source region
+// (whose obstacles are read) is the target grown by the reach once more.
+void ObstacleGrid::prepare_distance_field()
+{
+    const int reach = clearanceLimit + 1;
+    CellRegion wholeGrid{0, 0, gridWidth, gridHeight};
+    distanceTargetRegion = grow_region(dirtyRegion, reach);
+    distanceSourceRegion = grow_region(distanceTargetRegion, reach);
+
+    long long sourceArea = (long long)(distanceSourceRegion.lastColumn - distanceSourceRegion.firstColumn)*(distanceSourceRegion.lastRow - distanceSourceRegion.firstRow);
+    bool built = clearances.size() == gridWidth*gridHeight;
+    if (!built || 2*sourceArea > (long long)gridWidth*gridHeight)
     {
-        for (int i = 0; i < borderWidth; i++)
+        distanceTargetRegion = wholeGrid;
+        distanceSourceRegion = wholeGrid;
+    }
+    clearances.resize(gridWidth*gridHeight);
+    columnClearances.resize(gridWidth*gridHeight);
+}
+
+void ObstacleGrid::get_distance_update_columns(int& firstColumn, int& lastColumn) const
+{
+    firstColumn = distanceSourceRegion.firstColumn;
+    lastColumn = distanceSourceRegion.lastColumn;
+}
+
+void ObstacleGrid::get_distance_update_rows(int& firstRow, int& lastRow) const
+{
+    firstRow = distanceTargetRegion.firstRow;
+    lastRow = distanceTargetRegion.lastRow;
+}
+
+// First pass: distance to the nearest blocked cell in the same column of the
+// source region, counting the cells just above and below the grid as blocked.
+// Anything past the clearance limit cannot affect the capped result, so it is
+// clamped there, which also makes rows outside the source region irrelevant.
+void ObstacleGrid::build_distance_columns(const int& firstColumn, const int& lastColumn)
+{
+    const int farAway = clearanceLimit + 1;
+    const int firstRow = distanceSourceRegion.firstRow;
+    const int lastRow = distanceSourceRegion.lastRow;
+    for (int row = firstRow; row < lastRow; row++)
+    {
+        for (int column = firstColumn; column < lastColumn; column++)
         {
-            add_obstacle(x,0+i);
-            add_obstacle(x,worldHeight-i);
+            int outside = row == 0 ? 1 : farAway;
+            int above = row == firstRow ? outside : std::min(columnClearances[(row - 1)*gridWidth + column] + 1, farAway);
+            columnClearances[row*gridWidth + column] = is_blocked(column, row) ? 0 : above;
         }
     }
-    for (int y = 0; y <= worldHeight; y++)
+    for (int row = lastRow - 1; row >= firstRow; row--)
     {
-        for (int i = 0; i < borderWidth; i++)
+        for (int column = firstColumn; column < lastColumn; column++)
         {
-            add_obstacle(i,y);
-            add_obstacle(worldWidth-i,y);
+            int outside = row == gridHeight - 1 ? 1 : farAway;
+            int below = row == lastRow - 1 ? outside : columnClearances[(row + 1)*gridWidth + column] + 1;
+            if (below < columnClearances[row*gridWidth + column])
+            {
+                columnClearances[row*gridWidth + column] = below;
+            }
         }
     }
 }
 
+// Second pass: lower envelope of the parabolas (column - q)^2 + g(q)^2 along
+// each row of the source region, with one extra cell on each side of the row.
+// That cell is blocked at the grid edge and far away inside the grid.
+void ObstacleGrid::build_distance_rows(const int& firstRow, const int& lastRow)
+{
+    const int farAway = clearanceLimit + 1;
+    const int sourceColumn = distanceSourceRegion.firstColumn;
+    const int count = distanceSourceRegion.lastColumn - sourceColumn + 2;
+    std::vector<int> squaredColumnDistances(count);
+    std::vector<int> parabolaColumns(count);
+    std::vector<double> boundaries(count + 1);
+
+    for (int row = firstRow; row < lastRow; row++)
+    {
+        squaredColumnDistances[0] = sourceColumn == 0 ? 0 : farAway*farAway;
+        squaredColumnDistances[count - 1] = distanceSourceRegion.lastColumn == gridWidth ? 0 : farAway*farAway;
+        for (int q = 1; q < count - 1; q++)
+        {
+            int distance = columnClearances[row*gridWidth + sourceColumn + q - 1];
+            squaredColumnDistances[q] = distance*distance;
+        }
+
+        int parabolas = 0;
+        parabolaColumns[0] = 0;
+        boundaries[0] = -1e30;
+        boundaries[1] = 1e30;
+        for (int q = 1; q < count; q++)
+        {
+            int v = parabolaColumns[parabolas];
+            double boundary = ((squaredColumnDistances[q] + double(q)*q) - (squaredColumnDistances[v] + double(v)*v))/(2.0*(q - v));
+            while (boundary <= boundaries[parabolas])
+            {
+                parabolas--;
+                v = parabolaColumns[parabolas];
+                boundary = ((squaredColumnDistances[q] + double(q)*q) - (squaredColumnDistances[v] + double(v)*v))/(2.0*(q - v));
+            }
+            parabolas++;
+            parabolaColumns[parabolas] = q;
+            boundaries[parabolas] = boundary;
+            boundaries[parabolas + 1] = 1e30;
+        }
+
+        int parabola = 0;
+        for (int column = distanceTargetRegion.firstColumn; column < distanceTargetRegion.lastColumn; column++)
+        {
+            int q = column - sourceColumn + 1;
+            while (boundaries[parabola + 1] < q)
+            {
+                parabola++;
+            }
+            int v = parabolaColumns[parabola];
+            int squaredDistance = (q - v)*(q - v) + squaredColumnDistances[v];
+            int clearance = int(std::sqrt(double(squaredDistance)));
+            while ((clearance + 1)*(clearance + 1) <= squaredDistance)
+            {
+                clearance++;
+            }
+            while (clearance*clearance > squaredDistance)
+            {
+                clearance--;
+            }
+            clearances[row*gridWidth + column] = std::min(clearance, clearanceLimit);
+        }
+    }
+}
+
+void ObstacleGrid::finish_distance_field()
+{
+    hasDirtyRegion = false;
+}
+
+bool ObstacleGrid::has_dirty_region() const
+{
+    return hasDirtyRegion;
+}
+
+void ObstacleGrid::get_dirty_region(int& firstColumn, int& firstRow, int& lastColumn, int& lastRow) const
+{
+    firstColumn = dirtyRegion.firstColumn;
+    firstRow = dirtyRegion.firstRow;
+    lastColumn = dirtyRegion.lastColumn;
+    lastRow = dirtyRegion.lastRow;
+}
+
+void ObstacleGrid::mark_dirty(const int& firstColumn, const int& firstRow, const int& lastColumn, const int& lastRow)
+{
+    if (!hasDirtyRegion)
+    {
+        dirtyRegion = CellRegion{firstColumn, firstRow, lastColumn, lastRow};
+        hasDirtyRegion = true;
+        return;
+    }
+    dirtyRegion.firstColumn = std::min(dirtyRegion.firstColumn, firstColumn);
+    dirtyRegion.firstRow = std::min(dirtyRegion.firstRow, firstRow);
+    dirtyRegion.lastColumn = std::max(dirtyRegion.lastColumn, lastColumn);
+    dirtyRegion.lastRow = std::max(dirtyRegion.lastRow, lastRow);
+}
+
+ObstacleGrid::CellRegion ObstacleGrid::grow_region(const CellRegion& region, const int& margin) const
+{
+    return CellRegion{std::max(region.firstColumn - margin, 0), std::max(region.firstRow - margin, 0),
+                      std::min(region.lastColumn + margin, gridWidth), std::min(region.lastRow + margin, gridHeight)};
+}
+
 double generate_random_percent()
 {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(0, 100);
-    return dis(gen);
+    thread_local PcgStream stream{std::random_device{}(), std::random_device{}()};
+    return stream.next_double(0, 100);
 }
@@ -2,30 +2,73 @@
 #define OBSTACLEGRID_HPP
 
 #include "vector3D.hpp"
+#include "fastmath.hpp"
+#include "randomstreams.hpp"
 
+#include<cstdint>
 #include<vector>
 
+// Obstacles are stored as a bitboard: each grid row starts on a fresh 64-bit
+// word (bit i of a word is column 64*word + i) and the padding bits past the
+// last column are always zero. Cells outside the grid count as obstacles.
+//
+// An optional distance field stores each cell's clearance: the Euclidean
+// distance in cells to the nearest obstacle or outside cell, rounded down and
+// capped at the clearance limit (at most maxClearance). It is rebuilt with a
+// column pass and then a row pass (Meijster et al.), each of which can be
+// split across threads. While it is current, ray probes jump over open ground
+// in steps the clearance proves free and hand the last stretch near a wall
+// back to the word scan.
+//
+// Every edit grows a dirty region, which is reset once the field is brought up
+// to date. A clearance only depends on obstacles less than the limit + 1 away,
+// so prepare_distance_field() recomputes just the dirty region grown by that
+// reach, reading obstacles from one more reach around it, and falls back to
+// the whole grid when that window would cover most of it.
+//
+// Rays are either sampled once per unit step (steppedRaycast, which can repeat
+// cells on diagonals and slip between two diagonal wall cells) or traversed
+// cell by cell (traversalRaycast, Amanatides & Woo), which visits every cell
+// the ray crosses exactly once and reports the distance at which it enters the
+// blocked cell.
+enum RaycastMode { steppedRaycast, traversalRaycast };
+
+struct RayHit
+{
+    bool blocked;
+    double distance;
+    int column;
+    int row;
+};
+
 class ObstacleGrid
 {
 public:
     ObstacleGrid();
     ObstacleGrid(const int& width, const int& height);
 
-    int get_width();
-    int get_height();
+    int get_width() const;
+    int get_height() const;
     int get_index(const double& x, const double& y) const;
     Vector3D get_location(const int& index);
     std::vector<Vector3D> get_obstacle_locations();
     std::vector<bool> get_obstacle_vector();
+    const std::vector<std::uint64_t>& get_obstacle_words() const;
+    int get_words_per_row() const;
+    int get_border_width() const;
+    TrigMode get_trig_mode();
+    void set_trig_mode(const TrigMode& mode);
 
     void add_vertical_obstacle_line(const int& x1, const int& y1, const int& y2, const int& thickness);
     void add_obstacle_line(const int &x1, const int &y1, const int &x2, const int &y2, const int &thickness);
     void add_obstacle_circle(const int& x, const int& y, const double& radius);
 
     void generate_random_caves();
+    void generate_random_caves(PcgStream& stream);
     void randomly_fill_map(const int& fillPercent);
+    void randomly_fill_map(const int& fillPercent, PcgStream& stream);
     void smooth();
-    double get_neighbor_wall_count(const int &x, const int &y, const std::vector<bool>& obstacleCopy);
+    double get_neighbor_wall_count(const int &x, const int &y, const std::vector<std::uint64_t>& obstacleWordsCopy);
     void fill_square(const int& x, const int& y);
     void unfill_square(const int& x, const int& y);
 
@@ -33,14 +76,56 @@ public:
     void clear();
 
     bool check_obstacle(const double& x, const double& y) const;
+    bool is_blocked(const int& column, const int& row) const;
     bool check_for_obstacle_front(const Vector3D& locationVector, const double& orientation, const int& detectionRange) const;
     int check_obstacle_distance(const Vector3D& locationVector, const double& orientation, const int& detectionRange) const;
+    RayHit cast_ray(const Vector3D& locationVector, const double& orientation, const int& detectionRange) const;
+    bool cast_avoidance_rays(const Vector3D& locationVector, const double& orientation, const double& turnAngle, const int& detectionRange, int& rightDistance, int& leftDistance) const;
+    RaycastMode get_raycast_mode() const;
+    void set_raycast_mode(const RaycastMode& mode);
 
     void add_obstacle(const int& x, const int& y);
     void remove_obstacle(const int& x, const int& y);
     void fill_borders();
 
+    bool is_distance_field_enabled() const;
+    void set_distance_field_enabled(const bool& enabled);
+    bool is_distance_field_current() const;
+    int get_clearance(const int& column, const int& row) const;
+    // Lower limits make repairs cheaper but skips shorter; a limit just past
+    // the longest ray cast loses nothing.
+    int get_clearance_limit() const;
+    void set_clearance_limit(const int& limit);
+    void build_distance_field();
+    void prepare_distance_field();
+    void build_distance_columns(const int& firstColumn, const int& lastColumn);
+    void build_distance_rows(const int& firstRow, const int& lastRow);
+    void finish_distance_field();
+    bool has_dirty_region() const;
+    void get_dirty_region(int& firstColumn, int& firstRow, int& lastColumn, int& lastRow) const;
+    void get_distance_update_columns(int& firstColumn, int& lastColumn) const;
+    void get_distance_update_rows(int& firstRow, int& lastRow) const;
+
+    static const int maxClearance;
+
 private:
+    struct CellRegion
+    {
+        int firstColumn;
+        int firstRow;
+        int lastColumn;
+        int lastRow;
+    };
+
+    void mark_dirty(const int& firstColumn, const int& firstRow, const int& lastColumn, const int& lastRow);
+    CellRegion grow_region(const CellRegion& region, const int& margin) const;
+    void set_row_span(const int& row, const int& firstColumn, const int& lastColumn, const bool& filled);
+    std::uint64_t get_row_bits(const std::vector<std::uint64_t>& words, const int& row, const int& firstColumn, const int& count) const;
+    bool find_obstacle_in_row(const int& row, const int& fromColumn, const int& toColumn, int& hitColumn) const;
+    int march_ray(const Vector3D& locationVector, const double& orientation, const int& detectionRange) const;
+    int probe_ray(const Vector3D& locationVector, const double& orientation, const int& detectionRange) const;
+    int skip_clear_steps(const double& startX, const double& startY, const double& stepX, const double& stepY, const int& detectionRange) const;
+
     int worldWidth;
     int worldHeight;
     int gridWidth;
@@ -50,8 +135,20 @@ private:
     int smoothIterations{10};
     int randomSquareSize{5};
     int verticalLineLimit{8};
+    TrigMode trigMode{libmTrig};
+    RaycastMode raycastMode{steppedRaycast};
+
+    int wordsPerRow{0};
+    std::vector<std::uint64_t> obstacleWords;
 
-    std::vector<bool> obstacles;
+    bool distanceFieldEnabled{false};
+    int clearanceLimit{maxClearance};
+    bool hasDirtyRegion{false};
+    CellRegion dirtyRegion{0, 0, 0, 0};
+    CellRegion distanceSourceRegion{0, 0, 0, 0};
+    CellRegion distanceTargetRegion{0, 0, 0, 0};
+    std::vector<unsigned char> clearances;
+    std::vector<std::uint16_t> columnClearances;
 };
 
 double generate_random_percent();
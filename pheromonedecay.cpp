@@ -0,0 +1,226 @@
+#include "pheromonedecay.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ANTSIM_X86_DECAY_KERNELS
+#include <immintrin.h>
+#define ANTSIM_TARGET(features) __attribute__((target(features)))
+#endif
+
+namespace
+{
+const int maxExactVectorLimit = 1 << 21;
+
+inline int decay_value(const int& value, const int& decayFactor, const int& decayValue, const int& decayLimit, const int& threshold)
+{
+    // Unsigned multiply wraps the same way as the 32-bit vector multiply.
+    int product = int(unsigned(decayFactor)*unsigned(value));
+    int linear = value > decayValue ? value - decayValue : 0;
+    return value >= threshold ? value - product/decayLimit : linear;
+}
+
+void decay_range_scalar(int* homePheromones, int* foodPheromones, const int& begin, const int& end, const int& decayValue, const int& decayLimit)
+{
+    int decayFactor = 3*decayValue;
+    int threshold = decayValue*decayLimit;
+    for (int i = begin; i < end; i++)
+    {
+        homePheromones[i] = decay_value(homePheromones[i], decayFactor, decayValue, decayLimit, threshold);
+        foodPheromones[i] = decay_value(foodPheromones[i], decayFactor, decayValue, decayLimit, threshold);
+    }
+}
+
+#ifdef ANTSIM_X86_DECAY_KERNELS
+ANTSIM_TARGET("sse4.2")
+inline __m128i decay_lanes_sse42(const __m128i& values, const __m128i& decayFactor, const __m128d& decayLimit, const __m128i& thresholdMinusOne, const __m128i& decayValue)
+{
+    __m128i product = _mm_mullo_epi32(values, decayFactor);
+    __m128d lowQuotient = _mm_div_pd(_mm_cvtepi32_pd(product), decayLimit);
+    __m128d highQuotient = _mm_div_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(product, product)), decayLimit);
+    __m128i quotient = _mm_unpacklo_epi64(_mm_cvttpd_epi32(lowQuotient), _mm_cvttpd_epi32(highQuotient));
+
+    __m128i exponential = _mm_sub_epi32(values, quotient);
+    __m128i linear = _mm_and_si128(_mm_sub_epi32(values, decayValue), _mm_cmpgt_epi32(values, decayValue));
+    return _mm_blendv_epi8(linear, exponential, _mm_cmpgt_epi32(values, thresholdMinusOne));
+}
+
+ANTSIM_TARGET("avx2")
+inline __m256i decay_lanes_avx2(const __m256i& values, const __m256i& decayFactor, const __m256d& decayLimit, const __m256i& thresholdMinusOne, const __m256i& decayValue)
+{
+    __m256i product = _mm256_mullo_epi32(values, decayFactor);
+    __m256d lowQuotient = _mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(product)), decayLimit);
+    __m256d highQuotient = _mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(product, 1)), decayLimit);
+    __m256i quotient = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm256_cvttpd_epi32(lowQuotient)), _mm256_cvttpd_epi32(highQuotient), 1);
+
+    __m256i exponential = _mm256_sub_epi32(values, quotient);
+    __m256i linear = _mm256_and_si256(_mm256_sub_epi32(values, decayValue), _mm256_cmpgt_epi32(values, decayValue));
+    return _mm256_blendv_epi8(linear, exponential, _mm256_cmpgt_epi32(values, thresholdMinusOne));
+}
+
+ANTSIM_TARGET("avx512f")
+inline __m512i decay_lanes_avx512(const __m512i& values, const __m512i& decayFactor, const __m512d& decayLimit, const __m512i& thresholdMinusOne, const __m512i& decayValue)
+{
+    __m512i product = _mm512_mullo_epi32(values, decayFactor);
+    __m512d lowQuotient = _mm512_div_pd(_mm512_cvtepi32_pd(_mm512_castsi512_si256(product)), decayLimit);
+    __m512d highQuotient = _mm512_div_pd(_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(product, 1)), decayLimit);
+    __m512i quotient = _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvttpd_epi32(lowQuotient)), _mm512_cvttpd_epi32(highQuotient), 1);
+
+    __m512i exponential = _mm512_sub_epi32(values, quotient);
+    __m512i linear = _mm512_maskz_sub_epi32(_mm512_cmpgt_epi32_mask(values, decayValue), values, decayValue);
+    return _mm512_mask_blend_epi32(_mm512_cmpgt_epi32_mask(values, thresholdMinusOne), linear, exponential);
+}
+#endif
+}
+
+void decay_pheromones(const DecayKernel& kernel, int* homePheromones, int* foodPheromones, const int& count, const int& decayValue, const int& decayLimit)
+{
+    DecayKernel usedKernel = kernel;
+    if (!is_decay_kernel_supported(kernel) || decayLimit >= maxExactVectorLimit)
+    {
+        usedKernel = scalarDecay;
+    }
+
+    switch (usedKernel)
+    {
+    case sse42Decay:
+        decay_pheromones_sse42(homePheromones, foodPheromones, count, decayValue, decayLimit);
+        break;
+    case avx2Decay:
+        decay_pheromones_avx2(homePheromones, foodPheromones, count, decayValue, decayLimit);
+        break;
+    case avx512Decay:
+        decay_pheromones_avx512(homePheromones, foodPheromones, count, decayValue, decayLimit);
+        break;
+    default:
+        decay_pheromones_scalar(homePheromones, foodPheromones, count, decayValue, decayLimit);
+        break;
+    }
+}
+
+void decay_pheromones_scalar(int* homePheromones, int* foodPheromones, const int& count, const int& decayValue, const int& decayLimit)
+{
+    decay_range_scalar(homePheromones, foodPheromones, 0, count, decayValue, decayLimit);
+}
+
+#ifdef ANTSIM_X86_DECAY_KERNELS
+
+ANTSIM_TARGET("sse4.2")
+void decay_pheromones_sse42(int* homePheromones, int* foodPheromones, const int& count, const int& decayValue, const int& decayLimit)
+{
+    __m128i decayFactorLanes = _mm_set1_epi32(3*decayValue);
+    __m128d decayLimitLanes = _mm_set1_pd(decayLimit);
+    __m128i thresholdLanes = _mm_set1_epi32(decayValue*decayLimit - 1);
+    __m128i decayValueLanes = _mm_set1_epi32(decayValue);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i* home = reinterpret_cast<__m128i*>(homePheromones + i);
+        __m128i* food = reinterpret_cast<__m128i*>(foodPheromones + i);
+        _mm_storeu_si128(home, decay_lanes_sse42(_mm_loadu_si128(home), decayFactorLanes, decayLimitLanes, thresholdLanes, decayValueLanes));
+        _mm_storeu_si128(food, decay_lanes_sse42(_mm_loadu_si128(food), decayFactorLanes, decayLimitLanes, thresholdLanes, decayValueLanes));
+    }
+    decay_range_scalar(homePheromones, foodPheromones, i, count, decayValue, decayLimit);
+}
+
+ANTSIM_TARGET("avx2")
+void decay_pheromones_avx2(int* homePheromones, int* foodPheromones, const int& count, const int& decayValue, const int& decayLimit)
+{
+    __m256i decayFactorLanes = _mm256_set1_epi32(3*decayValue);
+    __m256d decayLimitLanes = _mm256_set1_pd(decayLimit);
+    __m256i thresholdLanes = _mm256_set1_epi32(decayValue*decayLimit - 1);
+    __m256i decayValueLanes = _mm256_set1_epi32(decayValue);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i* home = reinterpret_cast<__m256i*>(homePheromones + i);
+        __m256i* food = reinterpret_cast<__m256i*>(foodPheromones + i);
+        _mm256_storeu_si256(home, decay_lanes_avx2(_mm256_loadu_si256(home), decayFactorLanes, decayLimitLanes, thresholdLanes, decayValueLanes));
+        _mm256_storeu_si256(food, decay_lanes_avx2(_mm256_loadu_si256(food), decayFactorLanes, decayLimitLanes, thresholdLanes, decayValueLanes));
+    }
+    // GCC does not add vzeroupper to target() functions. Leaving the upper
+    // halves dirty makes every later non-VEX SSE instruction, such as those
+    // in libm's sin and cos, pay a state transition penalty.
+    _mm256_zeroupper();
+    decay_range_scalar(homePheromones, foodPheromones, i, count, decayValue, decayLimit);
+}
+
+ANTSIM_TARGET("avx512f")
+void decay_pheromones_avx512(int* homePheromones, int* foodPheromones, const int& count, const int& decayValue, const int& decayLimit)
+{
+    __m512i decayFactorLanes = _mm512_set1_epi32(3*decayValue);
+    __m512d decayLimitLanes = _mm512_set1_pd(decayLimit);
+    __m512i thresholdLanes = _mm512_set1_epi32(decayValue*decayLimit - 1);
+    __m512i decayValueLanes = _mm512_set1_epi32(decayValue);
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        int* home = homePheromones + i;
+        int* food = foodPheromones + i;
+        _mm512_storeu_si512(home, decay_lanes_avx512(_mm512_loadu_si512(home), decayFactorLanes, decayLimitLanes, thresholdLanes, decayValueLanes));
+        _mm512_storeu_si512(food, decay_lanes_avx512(_mm512_loadu_si512(food), decayFactorLanes, decayLimitLanes, thresholdLanes, decayValueLanes));
+    }
+    _mm256_zeroupper();
+    decay_range_scalar(homePheromones, foodPheromones, i, count, decayValue, decayLimit);
+}
+
+bool is_decay_kernel_supported(const DecayKernel& kernel)
+{
+    static const bool hasSse42 = __builtin_cpu_supports("sse4.2");
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    static const bool hasAvx512 = __builtin_cpu_supports("avx512f");
+
+    switch (kernel)
+    {
+    case sse42Decay:
+        return hasSse42;
+    case avx2Decay:
+        return hasAvx2;
+    case avx512Decay:
+        return hasAvx512;
+    default:
+        return true;
+    }
+}
+
+#else
+
+void decay_pheromones_sse42(int* homePheromones, int* foodPheromones, const int& count, const int& decayValue, const int& decayLimit)
+{
+    decay_pheromones_scalar(homePheromones, foodPheromones, count, decayValue, decayLimit);
+}
+
+void decay_pheromones_avx2(int* homePheromones, int* foodPheromones, const int& count, const int& decayValue, const int& decayLimit)
+{
+    decay_pheromones_scalar(homePheromones, foodPheromones, count, decayValue, decayLimit);
+}
+
+void decay_pheromones_avx512(int* homePheromones, int* foodPheromones, const int& count, const int& decayValue, const int& decayLimit)
+{
+    decay_pheromones_scalar(homePheromones, foodPheromones, count, decayValue, decayLimit);
+}
+
+bool is_decay_kernel_supported(const DecayKernel& kernel)
+{
+    return kernel == scalarDecay;
+}
+
+#endif
+
+DecayKernel get_best_decay_kernel()
+{
+    if (is_decay_kernel_supported(avx512Decay))
+    {
+        return avx512Decay;
+    }
+    if (is_decay_kernel_supported(avx2Decay))
+    {
+        return avx2Decay;
+    }
+    if (is_decay_kernel_supported(sse42Decay))
+    {
+        return sse42Decay;
+    }
+    return scalarDecay;
+}
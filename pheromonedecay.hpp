@@ -0,0 +1,24 @@
+#ifndef PHEROMONEDECAY_HPP
+#define PHEROMONEDECAY_HPP
+
+// Fused decay kernels for both pheromone channels. Every kernel reproduces
+// PheromoneGrid::decay_pheromone_vector exactly:
+//   value >= decayValue*decayLimit  ->  value - 3*decayValue*value/decayLimit
+//   value >  decayValue             ->  value - decayValue
+//   otherwise                       ->  0
+// The vector kernels divide in double precision, which is exact while the
+// limit stays below 2^21; decay_pheromones() falls back to scalar above that.
+
+enum DecayKernel { scalarDecay, sse42Decay, avx2Decay, avx512Decay };
+
+void decay_pheromones(const DecayKernel& kernel, int* homePheromones, int* foodPheromones, const int& count, const int& decayValue, const int& decayLimit);
+
+void decay_pheromones_scalar(int* homePheromones, int* foodPheromones, const int& count, const int& decayValue, const int& decayLimit);
+void decay_pheromones_sse42(int* homePheromones, int* foodPheromones, const int& count, const int& decayValue, const int& decayLimit);
+void decay_pheromones_avx2(int* homePheromones, int* foodPheromones, const int& count, const int& decayValue, const int& decayLimit);
+void decay_pheromones_avx512(int* homePheromones, int* foodPheromones, const int& count, const int& decayValue, const int& decayLimit);
+
+bool is_decay_kernel_supported(const DecayKernel& kernel);
+DecayKernel get_best_decay_kernel();
+
+#endif // PHEROMONEDECAY_HPP
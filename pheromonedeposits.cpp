@@ -0,0 +1,94 @@
+#include "pheromonedeposits.hpp"
+
+PheromoneDeposits::PheromoneDeposits()
+{
+}
+
+// Drops anything recorded; only called between merges.
+void PheromoneDeposits::resize(const int& tileRows)
+{
+    rowDeposits.assign(tileRows, std::vector<PheromoneDeposit>());
+    edgeDeposits.clear();
+    usedRows.clear();
+    depositCount = 0;
+}
+
+int PheromoneDeposits::get_tile_rows() const
+{
+    return rowDeposits.size();
+}
+
+int PheromoneDeposits::size() const
+{
+    return depositCount;
+}
+
+bool PheromoneDeposits::empty() const
+{
+    return depositCount == 0;
+}
+
+// Only the rows that were used are cleared, and they keep their capacity.
+void PheromoneDeposits::clear()
+{
+    for (int i = 0; i < usedRows.size(); i++)
+    {
+        rowDeposits[usedRows[i]].clear();
+    }
+    usedRows.clear();
+    edgeDeposits.clear();
+    depositCount = 0;
+}
+
+const std::vector<PheromoneDeposit>& PheromoneDeposits::get_row_deposits(const int& tileRow) const
+{
+    return rowDeposits[tileRow];
+}
+
+const std::vector<PheromoneDeposit>& PheromoneDeposits::get_edge_deposits() const
+{
+    return edgeDeposits;
+}
+
+void PheromoneDeposits::spread_home_pheromone(const PheromoneGrid& grid, const int& x, const int& y, const int& pheromoneValue, const int& spread)
+{
+    PheromoneDeposit deposit = {x, y, pheromoneValue, spread, homeChannel};
+    add_deposit(grid, deposit);
+}
+
+void PheromoneDeposits::spread_food_pheromone(const PheromoneGrid& grid, const int& x, const int& y, const int& pheromoneValue, const int& spread)
+{
+    PheromoneDeposit deposit = {x, y, pheromoneValue, spread, foodChannel};
+    add_deposit(grid, deposit);
+}
+
+// get_index() maps y on its own and never skips a row, so a square that lies
+// on the grid covers one whole range of rows.
+void PheromoneDeposits::add_deposit(const PheromoneGrid& grid, const PheromoneDeposit& deposit)
+{
+    if (deposit.spread <= 0)
+    {
+        return;
+    }
+    depositCount++;
+
+    int gridWidth = grid.get_grid_width();
+    int lastColumn = grid.get_index(deposit.x + deposit.spread - 1, 0);
+    int firstRow = grid.get_index(0, deposit.y - deposit.spread)/gridWidth;
+    int lastRow = grid.get_index(0, deposit.y + deposit.spread - 1)/gridWidth;
+    if (deposit.x - deposit.spread < 0 || deposit.y - deposit.spread < 0 || lastColumn >= gridWidth || lastRow >= grid.get_grid_height())
+    {
+        edgeDeposits.push_back(deposit);
+        return;
+    }
+
+    int tileSize = grid.get_tile_size();
+    for (int tileRow = firstRow/tileSize; tileRow <= lastRow/tileSize; tileRow++)
+    {
+        if (rowDeposits[tileRow].empty())
+        {
+            usedRows.push_back(tileRow);
+        }
+        rowDeposits[tileRow].push_back(deposit);
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef PHEROMONEDEPOSITS_HPP
+#define PHEROMONEDEPOSITS_HPP
+
+#include "pheromonegrid.hpp"
+
+#include <vector>
+
+// One spread_*_pheromone call, kept as its square rather than its cells.
+struct PheromoneDeposit
+{
+    int x;
+    int y;
+    int value;
+    int spread;
+    PheromoneChannel channel;
+};
+
+// Private deposit list for one worker. Each spread is recorded once under
+// every tile row its square covers, so the grid can merge tile rows on
+// different workers and the work and memory follow the number of deposits
+// rather than the grid size. Squares that run off the grid are kept apart and
+// spread serially, which clips away their cells outside the grid.
+class PheromoneDeposits
+{
+public:
+    PheromoneDeposits();
+
+    void resize(const int& tileRows);
+    int get_tile_rows() const;
+    int size() const;
+    bool empty() const;
+    void clear();
+    const std::vector<PheromoneDeposit>& get_row_deposits(const int& tileRow) const;
+    const std::vector<PheromoneDeposit>& get_edge_deposits() const;
+
+    void spread_home_pheromone(const PheromoneGrid& grid, const int& x, const int& y, const int& pheromoneValue, const int& spread);
+    void spread_food_pheromone(const PheromoneGrid& grid, const int& x, const int& y, const int& pheromoneValue, const int& spread);
+
+protected:
+    void add_deposit(const PheromoneGrid& grid, const PheromoneDeposit& deposit);
+
+    std::vector<std::vector<PheromoneDeposit>> rowDeposits;
+    std::vector<PheromoneDeposit> edgeDeposits;
+    std::vector<int> usedRows;
+    int depositCount{0};
+};
+
+#endif // PHEROMONEDEPOSITS_HPP
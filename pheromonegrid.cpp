@@ -1,4 +1,10 @@
 #include "pheromonegrid.hpp"
+#include "pheromonedeposits.hpp"
+#include "simstats.hpp"
+#include "statehash.hpp"
+
+#include <algorithm>
+#include <cmath>
 
 PheromoneGrid::PheromoneGrid()
 {
@@ -15,32 +21,34 @@ PheromoneGrid::PheromoneGrid(const int& width, const int& height, const int& sca
     toFoodPheromones = std::vector<int>(gridWidth*gridHeight);
     fill(toHomePheromones.begin(), toHomePheromones.end(), 0);
     fill(toFoodPheromones.begin(), toFoodPheromones.end(), 0);
+
+    tilesWide = (gridWidth + tileSize - 1)/tileSize;
+    tilesHigh = (gridHeight + tileSize - 1)/tileSize;
+    tileActive = std::vector<unsigned char>(tilesWide*tilesHigh, 0);
+    rowActivatedTiles.resize(tilesHigh);
 }
 
 int PheromoneGrid::get_index(const int& x, const int& y) const
 {
-    int gridX;
-    int gridY;
+    return get_grid_coordinate(y)*gridWidth + get_grid_coordinate(x);
+}
 
-    if (x % scaling > scaling/2.0)
-    {
-        gridX = x/scaling + 1;
-    }
-    else
-    {
-        gridX = x/scaling;
-    }
+// get_index() does not check its bounds: a column off either side lands in
+// the neighbouring row and a row off the grid lands outside the cells.
+bool PheromoneGrid::is_on_grid(const int& x, const int& y) const
+{
+    int gridX = get_grid_coordinate(x);
+    int gridY = get_grid_coordinate(y);
+    return gridX >= 0 && gridX < gridWidth && gridY >= 0 && gridY < gridHeight;
+}
 
-    if (y % scaling > scaling/2.0)
-    {
-        gridY = y/scaling + 1;
-    }
-    else
+int PheromoneGrid::get_grid_coordinate(const int& value) const
+{
+    if (value % scaling > scaling/2.0)
     {
-        gridY = y/scaling;
+        return value/scaling + 1;
     }
-
-    return gridY*gridWidth + gridX;
+    return value/scaling;
 }
 
 Vector3D PheromoneGrid::get_location(const int& index)
@@ -53,17 +61,17 @@ Vector3D PheromoneGrid::get_location(const int& index)
     return Vector3D(x,y,0);
 }
 
-int PheromoneGrid::get_grid_width()
+int PheromoneGrid::get_grid_width() const
 {
     return gridWidth;
 }
 
-int PheromoneGrid::get_scaling()
+int PheromoneGrid::get_scaling() const
 {
     return scaling;
 }
 
-int PheromoneGrid::get_grid_height()
+int PheromoneGrid::get_grid_height() const
 {
     return gridHeight;
 }
@@ -73,46 +81,366 @@ int PheromoneGrid::get_pheromone_decay_value()
     return pheromoneDecayValue;
 }
 
+int PheromoneGrid::get_exponential_decay_limit()
+{
+    return exponentialDecayLimit;
+}
+
+DecayKernel PheromoneGrid::get_decay_kernel()
+{
+    return decayKernel;
+}
+
+void PheromoneGrid::set_decay_kernel(const DecayKernel& kernel)
+{
+    decayKernel = kernel;
+}
+
+bool PheromoneGrid::is_lazy_decay_enabled() const
+{
+    return lazyDecay;
+}
+
+void PheromoneGrid::set_lazy_decay(const bool& enabled)
+{
+    if (enabled == lazyDecay)
+    {
+        return;
+    }
+    if (enabled)
+    {
+        lastDecayTicks.assign(toHomePheromones.size(), decayTick);
+    }
+    else
+    {
+        apply_pending_decay();
+        lastDecayTicks.clear();
+    }
+    lazyDecay = enabled;
+}
+
+TrigMode PheromoneGrid::get_trig_mode() const
+{
+    return trigMode;
+}
+
+void PheromoneGrid::set_trig_mode(const TrigMode& mode)
+{
+    trigMode = mode;
+}
+
+SensingMode PheromoneGrid::get_sensing_mode() const
+{
+    return sensingMode;
+}
+
+void PheromoneGrid::set_sensing_mode(const SensingMode& mode)
+{
+    sensingMode = mode;
+    summedAreaTablesDirty = true;
+}
+
+int PheromoneGrid::get_summed_area_blocks() const
+{
+    return summedAreaBlocks;
+}
+
+void PheromoneGrid::set_summed_area_blocks(const int& blocks)
+{
+    summedAreaBlocks = std::max(1, blocks);
+}
+
 void PheromoneGrid::clear()
 {
-    for (int i = 0; i < toHomePheromones.size(); i++)
+    summedAreaTablesDirty = true;
+    for (int i = 0; i < activeTiles.size(); i++)
+    {
+        clear_tile(activeTiles[i]);
+        tileActive[activeTiles[i]] = 0;
+    }
+    activeTiles.clear();
+}
+
+int PheromoneGrid::get_tile_size() const
+{
+    return tileSize;
+}
+
+int PheromoneGrid::get_tile_count() const
+{
+    return tileActive.size();
+}
+
+int PheromoneGrid::get_tile_rows() const
+{
+    return tilesHigh;
+}
+
+int PheromoneGrid::get_tile_index(const int& cellIndex) const
+{
+    if (cellIndex < 0 || cellIndex >= get_cell_count())
+    {
+        return -1;
+    }
+    int column = cellIndex % gridWidth;
+    int row = cellIndex / gridWidth;
+    return (row/tileSize)*tilesWide + column/tileSize;
+}
+
+int PheromoneGrid::get_active_tile_count() const
+{
+    return activeTiles.size();
+}
+
+double PheromoneGrid::get_active_tile_occupancy() const
+{
+    if (tileActive.empty())
+    {
+        return 0;
+    }
+    return double(activeTiles.size())/tileActive.size();
+}
+
+const std::vector<int>& PheromoneGrid::get_active_tiles() const
+{
+    return activeTiles;
+}
+
+void PheromoneGrid::get_tile_bounds(const int& tile, int& firstColumn, int& firstRow, int& lastColumn, int& lastRow) const
+{
+    firstColumn = (tile % tilesWide)*tileSize;
+    firstRow = (tile / tilesWide)*tileSize;
+    lastColumn = std::min(firstColumn + tileSize, gridWidth);
+    lastRow = std::min(firstRow + tileSize, gridHeight);
+}
+
+void PheromoneGrid::activate_tile(const int& tile)
+{
+    if (tile < 0 || tile >= tileActive.size())
+    {
+        return;
+    }
+    if (tileActive[tile] == 0)
+    {
+        tileActive[tile] = 1;
+        activeTiles.push_back(tile);
+    }
+}
+
+bool PheromoneGrid::decay_tile(const int& tile)
+{
+    int firstColumn, firstRow, lastColumn, lastRow;
+    get_tile_bounds(tile, firstColumn, firstRow, lastColumn, lastRow);
+
+    int remaining{0};
+    for (int row = firstRow; row < lastRow; row++)
     {
-        toHomePheromones[i] = 0;
-        toFoodPheromones[i] = 0;
+        int* homeRow = toHomePheromones.data() + row*gridWidth + firstColumn;
+        int* foodRow = toFoodPheromones.data() + row*gridWidth + firstColumn;
+        decay_pheromones(decayKernel, homeRow, foodRow, lastColumn - firstColumn, pheromoneDecayValue, exponentialDecayLimit);
+        for (int column = 0; column < lastColumn - firstColumn; column++)
+        {
+            remaining |= homeRow[column] | foodRow[column];
+        }
     }
+    return remaining != 0;
 }
 
-std::vector<int> PheromoneGrid::get_home_pheromones()
+bool PheromoneGrid::is_tile_empty(const int& tile) const
 {
-    return toHomePheromones;
+    int firstColumn, firstRow, lastColumn, lastRow;
+    get_tile_bounds(tile, firstColumn, firstRow, lastColumn, lastRow);
+
+    for (int row = firstRow; row < lastRow; row++)
+    {
+        for (int index = row*gridWidth + firstColumn; index < row*gridWidth + lastColumn; index++)
+        {
+            int decaySteps = lazyDecay ? get_pending_decay_steps(index) : 0;
+            if (decay_pheromone_value(toHomePheromones[index], decaySteps) != 0 || decay_pheromone_value(toFoodPheromones[index], decaySteps) != 0)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
 }
 
-std::vector<int> PheromoneGrid::get_food_pheromones()
+void PheromoneGrid::clear_tile(const int& tile)
 {
-    return toFoodPheromones;
+    int firstColumn, firstRow, lastColumn, lastRow;
+    get_tile_bounds(tile, firstColumn, firstRow, lastColumn, lastRow);
+
+    for (int row = firstRow; row < lastRow; row++)
+    {
+        for (int index = row*gridWidth + firstColumn; index < row*gridWidth + lastColumn; index++)
+        {
+            toHomePheromones[index] = 0;
+            toFoodPheromones[index] = 0;
+        }
+    }
+}
+
+// In lazy mode nothing is decayed eagerly, so tiles are retired by checking
+// now and then whether every cell has decayed to zero.
+void PheromoneGrid::sweep_lazy_tiles()
+{
+    int keptTiles{0};
+    for (int i = 0; i < activeTiles.size(); i++)
+    {
+        int tile = activeTiles[i];
+        if (is_tile_empty(tile))
+        {
+            clear_tile(tile);
+            tileActive[tile] = 0;
+        }
+        else
+        {
+            activeTiles[keptTiles++] = tile;
+        }
+    }
+    activeTiles.resize(keptTiles);
+}
+
+std::vector<int> PheromoneGrid::get_home_pheromones() const
+{
+    return export_pheromones(homeChannel);
+}
+
+std::vector<int> PheromoneGrid::get_food_pheromones() const
+{
+    return export_pheromones(foodChannel);
+}
+
+// Cells outside the active tiles are zero, so only those tiles are read.
+std::vector<int> PheromoneGrid::export_pheromones(const PheromoneChannel& channel) const
+{
+    std::vector<int> cells(get_cell_count(), 0);
+    for (int i = 0; i < activeTiles.size(); i++)
+    {
+        int firstColumn, firstRow, lastColumn, lastRow;
+        get_tile_bounds(activeTiles[i], firstColumn, firstRow, lastColumn, lastRow);
+        for (int row = firstRow; row < lastRow; row++)
+        {
+            for (int index = row*gridWidth + firstColumn; index < row*gridWidth + lastColumn; index++)
+            {
+                cells[index] = get_pheromone_at(channel, index);
+            }
+        }
+    }
+    return cells;
+}
+
+void PheromoneGrid::export_active_tiles(const PheromoneChannel& channel, std::vector<int>& tiles, std::vector<int>& values) const
+{
+    int tileCells = tileSize*tileSize;
+    tiles = activeTiles;
+    values.assign(activeTiles.size()*tileCells, 0);
+    for (int i = 0; i < activeTiles.size(); i++)
+    {
+        int firstColumn, firstRow, lastColumn, lastRow;
+        get_tile_bounds(activeTiles[i], firstColumn, firstRow, lastColumn, lastRow);
+        int* tileValues = values.data() + i*tileCells;
+        for (int row = firstRow; row < lastRow; row++)
+        {
+            for (int column = firstColumn; column < lastColumn; column++)
+            {
+                tileValues[(row - firstRow)*tileSize + column - firstColumn] = get_pheromone_at(channel, row*gridWidth + column);
+            }
+        }
+    }
+}
+
+ConstSpan<int> PheromoneGrid::view_home_pheromones() const
+{
+    return ConstSpan<int>(toHomePheromones);
+}
+
+ConstSpan<int> PheromoneGrid::view_food_pheromones() const
+{
+    return ConstSpan<int>(toFoodPheromones);
 }
 
 int PheromoneGrid::get_home_pheromone(const int& x, const int& y) const
 {
-    int index = get_index(x,y);
-    return toHomePheromones[index];
+    return get_home_pheromone_at(get_index(x,y));
 }
 
 int PheromoneGrid::get_food_pheromone(const int& x, const int& y) const
 {
-    int index = get_index(x,y);
+    return get_food_pheromone_at(get_index(x,y));
+}
+
+int PheromoneGrid::get_cell_count() const
+{
+    return gridWidth*gridHeight;
+}
+
+// Hashes the values a reader would see, so eager and lazy decay hash equal.
+std::uint64_t PheromoneGrid::hash_cells(const int& begin, const int& end) const
+{
+    std::uint64_t hash = initialStateHash;
+    for (int index = begin; index < end; index++)
+    {
+        std::uint64_t home = std::uint32_t(get_home_pheromone_at(index));
+        std::uint64_t food = std::uint32_t(get_food_pheromone_at(index));
+        hash = hash_value(hash, (home << 32) | food);
+    }
+    return hash;
+}
+
+int PheromoneGrid::get_home_pheromone_at(const int& index) const
+{
+    if (lazyDecay)
+    {
+        return decay_pheromone_value(toHomePheromones[index], get_pending_decay_steps(index));
+    }
+    return toHomePheromones[index];
+}
+
+int PheromoneGrid::get_pheromone_at(const PheromoneChannel& channel, const int& index) const
+{
+    return channel == homeChannel ? get_home_pheromone_at(index) : get_food_pheromone_at(index);
+}
+
+int PheromoneGrid::get_food_pheromone_at(const int& index) const
+{
+    if (lazyDecay)
+    {
+        return decay_pheromone_value(toFoodPheromones[index], get_pending_decay_steps(index));
+    }
     return toFoodPheromones[index];
 }
 
+// Cells off the grid are dropped, so spreads near an edge are clipped.
 void PheromoneGrid::add_home_pheromone(const int& x, const int& y, const int& pheromoneValue)
 {
+    if (!is_on_grid(x,y))
+    {
+        return;
+    }
     int index = get_index(x,y);
+    summedAreaTablesDirty = true;
+    activate_tile(get_tile_index(index));
+    if (lazyDecay)
+    {
+        apply_pending_decay(index);
+    }
     toHomePheromones[index] += pheromoneValue;
 }
 
 void PheromoneGrid::add_food_pheromone(const int& x, const int& y, const int& pheromoneValue)
 {
+    if (!is_on_grid(x,y))
+    {
+        return;
+    }
     int index = get_index(x,y);
+    summedAreaTablesDirty = true;
+    activate_tile(get_tile_index(index));
+    if (lazyDecay)
+    {
+        apply_pending_decay(index);
+    }
     toFoodPheromones[index] += pheromoneValue;
 }
 
@@ -138,10 +466,134 @@ void PheromoneGrid::spread_food_pheromone(const int &x, const int &y, const int
     }
 }
 
+// Adds the deposits filed under tile rows [firstTileRow, lastTileRow). Each
+// row's cells and tiles belong to that row alone, so disjoint row ranges can
+// be merged by different workers. Integer sums do not depend on order, and
+// lazy decay is caught up per cell exactly as add_*_pheromone() does.
+void PheromoneGrid::merge_deposits(const std::vector<PheromoneDeposits>& deposits, const int& firstTileRow, const int& lastTileRow)
+{
+    for (int tileRow = firstTileRow; tileRow < lastTileRow; tileRow++)
+    {
+        for (int i = 0; i < deposits.size(); i++)
+        {
+            const std::vector<PheromoneDeposit>& rowDeposits = deposits[i].get_row_deposits(tileRow);
+            for (int j = 0; j < rowDeposits.size(); j++)
+            {
+                merge_deposit(rowDeposits[j], tileRow);
+            }
+        }
+    }
+}
+
+void PheromoneGrid::merge_deposit(const PheromoneDeposit& deposit, const int& tileRow)
+{
+    std::vector<int>& cells = deposit.channel == homeChannel ? toHomePheromones : toFoodPheromones;
+    int firstRow = tileRow*tileSize;
+    int lastRow = std::min(firstRow + tileSize, gridHeight);
+    int firstColumn = get_index(deposit.x - deposit.spread, 0);
+    int lastColumn = get_index(deposit.x + deposit.spread - 1, 0);
+
+    for (int yNew = deposit.y - deposit.spread; yNew < deposit.y + deposit.spread; yNew++)
+    {
+        int row = get_index(0, yNew)/gridWidth;
+        if (row < firstRow || row >= lastRow)
+        {
+            continue;
+        }
+        if (scaling == 1)
+        {
+            for (int index = row*gridWidth + firstColumn; index <= row*gridWidth + lastColumn; index++)
+            {
+                if (lazyDecay)
+                {
+                    apply_pending_decay(index);
+                }
+                cells[index] += deposit.value;
+            }
+        }
+        else
+        {
+            for (int xNew = deposit.x - deposit.spread; xNew < deposit.x + deposit.spread; xNew++)
+            {
+                int index = row*gridWidth + get_index(xNew, 0);
+                if (lazyDecay)
+                {
+                    apply_pending_decay(index);
+                }
+                cells[index] += deposit.value;
+            }
+        }
+    }
+
+    for (int tileColumn = firstColumn/tileSize; tileColumn <= lastColumn/tileSize; tileColumn++)
+    {
+        int tile = tileRow*tilesWide + tileColumn;
+        if (tileActive[tile] == 0)
+        {
+            tileActive[tile] = 1;
+            rowActivatedTiles[tileRow].push_back(tile);
+        }
+    }
+}
+
+// Runs after every tile row has been merged: lists the tiles the merge
+// activated, spreads the squares that run off the grid (clipped to it), and
+// empties the buffers.
+void PheromoneGrid::finish_deposits(std::vector<PheromoneDeposits>& deposits)
+{
+    summedAreaTablesDirty = true;
+    for (int tileRow = 0; tileRow < rowActivatedTiles.size(); tileRow++)
+    {
+        activeTiles.insert(activeTiles.end(), rowActivatedTiles[tileRow].begin(), rowActivatedTiles[tileRow].end());
+        rowActivatedTiles[tileRow].clear();
+    }
+
+    for (int i = 0; i < deposits.size(); i++)
+    {
+        const std::vector<PheromoneDeposit>& edgeDeposits = deposits[i].get_edge_deposits();
+        for (int j = 0; j < edgeDeposits.size(); j++)
+        {
+            const PheromoneDeposit& deposit = edgeDeposits[j];
+            if (deposit.channel == homeChannel)
+            {
+                spread_home_pheromone(deposit.x, deposit.y, deposit.value, deposit.spread);
+            }
+            else
+            {
+                spread_food_pheromone(deposit.x, deposit.y, deposit.value, deposit.spread);
+            }
+        }
+        deposits[i].clear();
+    }
+}
+
 void PheromoneGrid::decay_all_pheromones()
 {
-    decay_pheromone_vector(toHomePheromones);
-    decay_pheromone_vector(toFoodPheromones);
+    summedAreaTablesDirty = true;
+    if (lazyDecay)
+    {
+        decayTick++;
+        if (decayTick % lazyTileSweepInterval == 0)
+        {
+            sweep_lazy_tiles();
+        }
+        return;
+    }
+
+    int keptTiles{0};
+    for (int i = 0; i < activeTiles.size(); i++)
+    {
+        int tile = activeTiles[i];
+        if (decay_tile(tile))
+        {
+            activeTiles[keptTiles++] = tile;
+        }
+        else
+        {
+            tileActive[tile] = 0;
+        }
+    }
+    activeTiles.resize(keptTiles);
 }
 
 void PheromoneGrid::decay_pheromone_vector(std::vector<int> &pheromonesVector)
@@ -163,90 +615,355 @@ void PheromoneGrid::decay_pheromone_vector(std::vector<int> &pheromonesVector)
     }
 }
 
-double PheromoneGrid::average_food_pheromones_right(const Vector3D& locationVector, const double& orientation, const int& smellRange) const
+// Same result as decaying the value decaySteps times. Values at or above the
+// exponential limit are stepped one tick at a time until they drop below it;
+// after that each step removes pheromoneDecayValue until the value hits zero.
+int PheromoneGrid::decay_pheromone_value(const int& pheromoneValue, const int& decaySteps) const
 {
-    double rightAngle = orientation + 3.14/4.0;
+    int value = pheromoneValue;
+    int remainingSteps = decaySteps;
+    int threshold = pheromoneDecayValue*exponentialDecayLimit;
 
-    int numValues{0};
-    int sumValues{0};
-    for (int forwardDistance = 0; forwardDistance < smellRange; forwardDistance++)
+    while (remainingSteps > 0 && value >= threshold)
     {
-        for (double sideWidth = 0; sideWidth < smellRange; sideWidth += smellSamplingResolution)
+        int product = int(unsigned(3*pheromoneDecayValue)*unsigned(value));
+        value = value - product/exponentialDecayLimit;
+        remainingSteps--;
+    }
+    if (remainingSteps == 0)
+    {
+        return value;
+    }
+
+    long long linearValue = (long long)value - (long long)remainingSteps*pheromoneDecayValue;
+    return linearValue > 0 ? int(linearValue) : 0;
+}
+
+void PheromoneGrid::apply_pending_decay()
+{
+    if (!lazyDecay)
+    {
+        return;
+    }
+    for (int i = 0; i < activeTiles.size(); i++)
+    {
+        int firstColumn, firstRow, lastColumn, lastRow;
+        get_tile_bounds(activeTiles[i], firstColumn, firstRow, lastColumn, lastRow);
+        for (int row = firstRow; row < lastRow; row++)
         {
-            double newX = locationVector[0] + forwardDistance*cos(orientation) + sideWidth*cos(rightAngle);
-            double newY = locationVector[1] + forwardDistance*sin(orientation) + sideWidth*sin(rightAngle);
-            if (newX > 0 && newX < gridWidth && newY > 0 && newY < gridHeight)
+            for (int index = row*gridWidth + firstColumn; index < row*gridWidth + lastColumn; index++)
             {
-                numValues += 1;
-                sumValues += get_food_pheromone(newX, newY);
+                apply_pending_decay(index);
             }
         }
     }
-    return sumValues/numValues;
 }
 
-double PheromoneGrid::average_food_pheromones_left(const Vector3D& locationVector, const double& orientation, const int& smellRange) const
+int PheromoneGrid::get_pending_decay_steps(const int& index) const
 {
-    double leftAngle = orientation - 3.14/4.0;
+    return decayTick - lastDecayTicks[index];
+}
 
-    int numValues{0};
-    int sumValues{0};
-    for (int forwardDistance = 0; forwardDistance < smellRange; forwardDistance++)
+void PheromoneGrid::apply_pending_decay(const int& index)
+{
+    int decaySteps = get_pending_decay_steps(index);
+    if (decaySteps > 0)
     {
-        for (double sideWidth = 0; sideWidth < smellRange; sideWidth = sideWidth + smellSamplingResolution)
+        toHomePheromones[index] = decay_pheromone_value(toHomePheromones[index], decaySteps);
+        toFoodPheromones[index] = decay_pheromone_value(toFoodPheromones[index], decaySteps);
+        lastDecayTicks[index] = decayTick;
+    }
+}
+
+void PheromoneGrid::build_summed_area_tables()
+{
+    prepare_summed_area_tables();
+    build_summed_area_rows(0, gridHeight);
+    build_summed_area_columns(0, gridWidth + 1);
+    finish_summed_area_tables();
+}
+
+void PheromoneGrid::prepare_summed_area_tables()
+{
+    int tableSize = (gridWidth + 1)*(gridHeight + 1);
+    if (homeSums.size() != tableSize)
+    {
+        homeSums.assign(tableSize, 0);
+        foodSums.assign(tableSize, 0);
+    }
+}
+
+// Rows and columns can be built in parallel over disjoint ranges, but every
+// row must be finished before the first column is started.
+void PheromoneGrid::build_summed_area_rows(const int& firstRow, const int& lastRow)
+{
+    int tableWidth = gridWidth + 1;
+
+    for (int row = firstRow; row < lastRow; row++)
+    {
+        long long homeSum{0};
+        long long foodSum{0};
+        for (int column = 0; column < gridWidth; column++)
         {
-            double newX = locationVector[0]+forwardDistance*cos(orientation)+sideWidth*cos(leftAngle);
-            double newY = locationVector[1]+forwardDistance*sin(orientation)+sideWidth*sin(leftAngle);
-            if (newX > 0 && newX < gridWidth && newY > 0 && newY < gridHeight)
+            int index = row*gridWidth + column;
+            homeSum += get_home_pheromone_at(index);
+            foodSum += get_food_pheromone_at(index);
+            homeSums[(row + 1)*tableWidth + column + 1] = homeSum;
+            foodSums[(row + 1)*tableWidth + column + 1] = foodSum;
+        }
+    }
+}
+
+void PheromoneGrid::build_summed_area_columns(const int& firstColumn, const int& lastColumn)
+{
+    int tableWidth = gridWidth + 1;
+    for (int row = 2; row <= gridHeight; row++)
+    {
+        for (int column = firstColumn; column < lastColumn; column++)
+        {
+            homeSums[row*tableWidth + column] += homeSums[(row - 1)*tableWidth + column];
+            foodSums[row*tableWidth + column] += foodSums[(row - 1)*tableWidth + column];
+        }
+    }
+}
+
+void PheromoneGrid::finish_summed_area_tables()
+{
+    summedAreaTablesDirty = false;
+}
+
+bool PheromoneGrid::are_summed_area_tables_current() const
+{
+    return !summedAreaTablesDirty;
+}
+
+long long PheromoneGrid::get_box_sum(const std::vector<long long>& sums, const int& firstColumn, const int& firstRow, const int& lastColumn, const int& lastRow) const
+{
+    int tableWidth = gridWidth + 1;
+    return sums[lastRow*tableWidth + lastColumn] - sums[firstRow*tableWidth + lastColumn]
+         - sums[lastRow*tableWidth + firstColumn] + sums[firstRow*tableWidth + firstColumn];
+}
+
+double PheromoneGrid::average_summed_area(const std::vector<long long>& sums, const Vector3D& locationVector, const double& orientation, const double& sideAngle, const int& smellRange) const
+{
+    double blockLength = double(smellRange)/summedAreaBlocks;
+    int boxSide = std::max(1, int(blockLength/scaling + 0.5));
+    double cosForward, sinForward, cosSide, sinSide;
+    trig_sin_cos(trigMode, orientation, sinForward, cosForward);
+    trig_sin_cos(trigMode, sideAngle, sinSide, cosSide);
+
+    long long numValues{0};
+    long long sumValues{0};
+    int boxes{0};
+    for (int forwardBlock = 0; forwardBlock < summedAreaBlocks; forwardBlock++)
+    {
+        // The exact sampler reads integer distances, so the centroid of a
+        // block is the mean of the integers it covers.
+        double forwardDistance = (forwardBlock + 0.5)*blockLength - 0.5;
+        for (int sideBlock = 0; sideBlock < summedAreaBlocks; sideBlock++)
+        {
+            double sideWidth = (sideBlock + 0.5)*blockLength - 0.5;
+            double gridX = (locationVector[0] + forwardDistance*cosForward + sideWidth*cosSide)/scaling;
+            double gridY = (locationVector[1] + forwardDistance*sinForward + sideWidth*sinSide)/scaling;
+
+            int firstColumn = std::max(0, int(floor(gridX - (boxSide - 1)/2.0 + 0.5)));
+            int firstRow = std::max(0, int(floor(gridY - (boxSide - 1)/2.0 + 0.5)));
+            int lastColumn = std::min(gridWidth, int(floor(gridX - (boxSide - 1)/2.0 + 0.5)) + boxSide);
+            int lastRow = std::min(gridHeight, int(floor(gridY - (boxSide - 1)/2.0 + 0.5)) + boxSide);
+            if (firstColumn < lastColumn && firstRow < lastRow)
             {
-                numValues += 1;
-                sumValues += get_food_pheromone(newX, newY);
+                numValues += (lastColumn - firstColumn)*(lastRow - firstRow);
+                sumValues += get_box_sum(sums, firstColumn, firstRow, lastColumn, lastRow);
+                boxes++;
             }
         }
     }
+    ANTSIM_COUNT(pheromoneSamplesCounter, boxes);
+    if (numValues == 0)
+    {
+        return 0;
+    }
     return sumValues/numValues;
 }
 
-double PheromoneGrid::average_home_pheromones_right(const Vector3D& locationVector, const double& orientation, const int& smellRange) const
+int PheromoneGrid::get_stencil_headings() const
+{
+    return stencilHeadings;
+}
+
+// The offsets follow the exact sampler, which truncates each sample to whole
+// world units, so for integer locations at a quantized heading they match it
+// up to floating-point rounding.
+void PheromoneGrid::build_sensing_stencils(const int& smellRange, const int& headings)
 {
-    double rightAngle = orientation + 3.14/4.0;
+    stencilSmellRange = smellRange;
+    stencilHeadings = std::max(1, headings);
+    stencilSamples = 0;
+    for (double sideWidth = 0; sideWidth < smellRange; sideWidth += smellSamplingResolution)
+    {
+        stencilSamples += smellRange;
+    }
+
+    int stencilCount = 2*stencilHeadings;
+    stencilColumnOffsets.assign(stencilCount*stencilSamples, 0);
+    stencilRowOffsets.assign(stencilCount*stencilSamples, 0);
+    stencilIndexOffsets.assign(stencilCount*stencilSamples, 0);
+    stencilBounds.assign(stencilCount*4, 0);
+
+    for (int heading = 0; heading < stencilHeadings; heading++)
+    {
+        double orientation = 2*M_PI*heading/stencilHeadings;
+        for (int side = leftSide; side <= rightSide; side++)
+        {
+            double sideAngle = side == rightSide ? orientation + 3.14/4.0 : orientation - 3.14/4.0;
+            int stencil = heading*2 + side;
+            int* bounds = stencilBounds.data() + stencil*4;
+            bounds[0] = bounds[1] = bounds[2] = bounds[3] = 0;
+
+            int sample = stencil*stencilSamples;
+            for (int forwardDistance = 0; forwardDistance < smellRange; forwardDistance++)
+            {
+                for (double sideWidth = 0; sideWidth < smellRange; sideWidth += smellSamplingResolution)
+                {
+                    double offsetX = forwardDistance*cos(orientation) + sideWidth*cos(sideAngle);
+                    double offsetY = forwardDistance*sin(orientation) + sideWidth*sin(sideAngle);
+                    int column = int(floor(floor(offsetX + 1e-9)/scaling + 0.5));
+                    int row = int(floor(floor(offsetY + 1e-9)/scaling + 0.5));
+
+                    stencilColumnOffsets[sample] = column;
+                    stencilRowOffsets[sample] = row;
+                    stencilIndexOffsets[sample] = row*gridWidth + column;
+                    bounds[0] = std::min(bounds[0], column);
+                    bounds[1] = std::min(bounds[1], row);
+                    bounds[2] = std::max(bounds[2], column);
+                    bounds[3] = std::max(bounds[3], row);
+                    sample++;
+                }
+            }
+        }
+    }
+}
+
+double PheromoneGrid::average_stencil(const PheromoneChannel& channel, const SensingSide& side, const Vector3D& locationVector, const double& orientation) const
+{
+    int heading = int(floor(orientation/(2*M_PI)*stencilHeadings + 0.5)) % stencilHeadings;
+    if (heading < 0)
+    {
+        heading += stencilHeadings;
+    }
+    int stencil = heading*2 + side;
+    const int* bounds = stencilBounds.data() + stencil*4;
+    const int* indexOffsets = stencilIndexOffsets.data() + stencil*stencilSamples;
+
+    int centerIndex = get_index(locationVector[0], locationVector[1]);
+    int centerColumn = centerIndex % gridWidth;
+    int centerRow = centerIndex / gridWidth;
 
+    long long sumValues{0};
     int numValues{0};
-    int sumValues{0};
-    for (int forwardDistance = 0; forwardDistance < smellRange; forwardDistance++)
+    if (centerColumn + bounds[0] >= 0 && centerColumn + bounds[2] < gridWidth && centerRow + bounds[1] >= 0 && centerRow + bounds[3] < gridHeight)
     {
-        for (double sideWidth = 0; sideWidth < smellRange; sideWidth = sideWidth + smellSamplingResolution)
+        numValues = stencilSamples;
+        if (!lazyDecay)
         {
-            double newX = locationVector[0] + forwardDistance*cos(orientation) + sideWidth*cos(rightAngle);
-            double newY = locationVector[1] + forwardDistance*sin(orientation) + sideWidth*sin(rightAngle);
-            if (newX > 0 && newX < gridWidth && newY > 0 && newY < gridHeight)
+            const int* values = channel == homeChannel ? toHomePheromones.data() : toFoodPheromones.data();
+            for (int i = 0; i < stencilSamples; i++)
+            {
+                sumValues += values[centerIndex + indexOffsets[i]];
+            }
+        }
+        else
+        {
+            for (int i = 0; i < stencilSamples; i++)
+            {
+                sumValues += get_pheromone_at(channel, centerIndex + indexOffsets[i]);
+            }
+        }
+    }
+    else
+    {
+        const int* columnOffsets = stencilColumnOffsets.data() + stencil*stencilSamples;
+        const int* rowOffsets = stencilRowOffsets.data() + stencil*stencilSamples;
+        for (int i = 0; i < stencilSamples; i++)
+        {
+            int column = centerColumn + columnOffsets[i];
+            int row = centerRow + rowOffsets[i];
+            if (column >= 0 && column < gridWidth && row >= 0 && row < gridHeight)
             {
                 numValues += 1;
-                sumValues += get_home_pheromone(newX, newY);
+                sumValues += get_pheromone_at(channel, centerIndex + indexOffsets[i]);
             }
         }
     }
+
+    ANTSIM_COUNT(pheromoneSamplesCounter, numValues);
+    if (numValues == 0)
+    {
+        return 0;
+    }
     return sumValues/numValues;
 }
 
-double PheromoneGrid::average_home_pheromones_left(const Vector3D& locationVector, const double& orientation, const int& smellRange) const
+double PheromoneGrid::average_pheromones(const PheromoneChannel& channel, const SensingSide& side, const Vector3D& locationVector, const double& orientation, const int& smellRange) const
+{
+    double sideAngle = side == rightSide ? orientation + 3.14/4.0 : orientation - 3.14/4.0;
+
+    if (sensingMode == summedAreaSensing && !summedAreaTablesDirty)
+    {
+        return average_summed_area(channel == homeChannel ? homeSums : foodSums, locationVector, orientation, sideAngle, smellRange);
+    }
+    if (sensingMode == stencilSensing && smellRange == stencilSmellRange)
+    {
+        return average_stencil(channel, side, locationVector, orientation);
+    }
+    return average_exact(channel, locationVector, orientation, sideAngle, smellRange);
+}
+
+double PheromoneGrid::average_exact(const PheromoneChannel& channel, const Vector3D& locationVector, const double& orientation, const double& sideAngle, const int& smellRange) const
 {
-    double leftAngle = orientation - 3.14/4.0;
+    double cosForward, sinForward, cosSide, sinSide;
+    trig_sin_cos(trigMode, orientation, sinForward, cosForward);
+    trig_sin_cos(trigMode, sideAngle, sinSide, cosSide);
 
     int numValues{0};
     int sumValues{0};
     for (int forwardDistance = 0; forwardDistance < smellRange; forwardDistance++)
     {
-        for (double sideWidth = 0; sideWidth < smellRange; sideWidth = sideWidth + smellSamplingResolution)
+        for (double sideWidth = 0; sideWidth < smellRange; sideWidth += smellSamplingResolution)
         {
-            double newX = locationVector[0]+forwardDistance*cos(orientation)+sideWidth*cos(leftAngle);
-            double newY = locationVector[1]+forwardDistance*sin(orientation)+sideWidth*sin(leftAngle);
+            double newX = locationVector[0] + forwardDistance*cosForward + sideWidth*cosSide;
+            double newY = locationVector[1] + forwardDistance*sinForward + sideWidth*sinSide;
             if (newX > 0 && newX < gridWidth && newY > 0 && newY < gridHeight)
             {
                 numValues += 1;
-                sumValues += get_home_pheromone(newX, newY);
+                sumValues += get_pheromone_at(channel, get_index(newX, newY));
             }
         }
     }
+    ANTSIM_COUNT(pheromoneSamplesCounter, numValues);
+    if (numValues == 0)
+    {
+        return 0;
+    }
     return sumValues/numValues;
 }
+
+double PheromoneGrid::average_food_pheromones_right(const Vector3D& locationVector, const double& orientation, const int& smellRange) const
+{
+    return average_pheromones(foodChannel, rightSide, locationVector, orientation, smellRange);
+}
+
+double PheromoneGrid::average_food_pheromones_left(const Vector3D& locationVector, const double& orientation, const int& smellRange) const
+{
+    return average_pheromones(foodChannel, leftSide, locationVector, orientation, smellRange);
+}
+
+double PheromoneGrid::average_home_pheromones_right(const Vector3D& locationVector, const double& orientation, const int& smellRange) const
+{
+    return average_pheromones(homeChannel, rightSide, locationVector, orientation, smellRange);
+}
+
+double PheromoneGrid::average_home_pheromones_left(const Vector3D& locationVector, const double& orientation, const int& smellRange) const
+{
+    return average_pheromones(homeChannel, leftSide, locationVector, orientation, smellRange);
+}
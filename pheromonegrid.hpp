@@ -2,9 +2,33 @@
 #define PHEROMONEGRID_HPP
 
 #include "vector3D.hpp"
+#include "pheromonedecay.hpp"
+#include "fastmath.hpp"
+#include "constspan.hpp"
 
+#include<cstdint>
 #include<vector>
 
+class PheromoneDeposits;
+struct PheromoneDeposit;
+
+// exactSensing samples every cell of the sensing wedge. summedAreaSensing
+// splits each wedge into summedAreaBlocks x summedAreaBlocks sub-blocks and
+// reads each one as an axis-aligned box of the same side length centered on
+// the sub-block centroid, using one summed-area table lookup per box. Because
+// the centroids match, the estimate is exact for any field that is linear
+// across each sub-block. For a field whose second derivative is bounded by M
+// it is within M*(smellRange/summedAreaBlocks)^2/2 of the exact average, plus
+// one cell of rounding where the exact sampler snaps to the nearest cell.
+// stencilSensing gathers from precomputed cell offsets for the nearest of
+// stencilHeadings quantized headings, so a sample lands at most
+// smellRange*pi/stencilHeadings away from where the exact sampler reads it,
+// plus one cell of rounding. Unlike the exact sampler, both approximations
+// clip against the grid's cells rather than the world coordinates.
+enum SensingMode { exactSensing, summedAreaSensing, stencilSensing };
+enum PheromoneChannel { homeChannel, foodChannel };
+enum SensingSide { leftSide, rightSide };
+
 class PheromoneGrid
 {
 public:
@@ -12,26 +36,77 @@ public:
     PheromoneGrid(const int& width, const int& height, const int& scale);
 
     int get_index(const int& x, const int& y) const;
+    bool is_on_grid(const int& x, const int& y) const;
     Vector3D get_location(const int& index);
-    int get_grid_width();
-    int get_scaling();
-    int get_grid_height();
+    int get_grid_width() const;
+    int get_scaling() const;
+    int get_grid_height() const;
     int get_pheromone_decay_value();
+    int get_exponential_decay_limit();
+    DecayKernel get_decay_kernel();
+    void set_decay_kernel(const DecayKernel& kernel);
+    bool is_lazy_decay_enabled() const;
+    void set_lazy_decay(const bool& enabled);
+    TrigMode get_trig_mode() const;
+    void set_trig_mode(const TrigMode& mode);
+    SensingMode get_sensing_mode() const;
+    void set_sensing_mode(const SensingMode& mode);
+    int get_summed_area_blocks() const;
+    void set_summed_area_blocks(const int& blocks);
+    int get_stencil_headings() const;
+    void build_sensing_stencils(const int& smellRange, const int& headings);
 
     void clear();
 
-    std::vector<int> get_home_pheromones();
-    std::vector<int> get_food_pheromones();
+    int get_tile_size() const;
+    int get_tile_count() const;
+    int get_tile_rows() const;
+    int get_tile_index(const int& cellIndex) const;
+    int get_active_tile_count() const;
+    double get_active_tile_occupancy() const;
+    const std::vector<int>& get_active_tiles() const;
+    void get_tile_bounds(const int& tile, int& firstColumn, int& firstRow, int& lastColumn, int& lastRow) const;
+    void activate_tile(const int& tile);
+
+    // Whole-grid copies, built from the active tiles and decayed to the
+    // current tick. Kept for callers that want a plain vector.
+    std::vector<int> get_home_pheromones() const;
+    std::vector<int> get_food_pheromones() const;
+    // Copies only the active tiles of one channel, decayed to the current
+    // tick: tiles[i]'s cells are values[i*tileSize*tileSize ...] in row-major
+    // order, with zeros past the grid's edge.
+    void export_active_tiles(const PheromoneChannel& channel, std::vector<int>& tiles, std::vector<int>& values) const;
+    // Raw cell storage without a copy. Under lazy decay the stored values can
+    // be behind by their pending decay steps; get_*_pheromone_at() applies it.
+    ConstSpan<int> view_home_pheromones() const;
+    ConstSpan<int> view_food_pheromones() const;
     int get_home_pheromone(const int& x, const int& y) const;
     int get_food_pheromone(const int& x, const int& y) const;
+    int get_cell_count() const;
+    std::uint64_t hash_cells(const int& begin, const int& end) const;
+    int get_home_pheromone_at(const int& index) const;
+    int get_food_pheromone_at(const int& index) const;
+    int get_pheromone_at(const PheromoneChannel& channel, const int& index) const;
 
     void add_home_pheromone(const int& x, const int& y, const int& pheromoneValue);
     void add_food_pheromone(const int& x, const int& y, const int& pheromoneValue);
     void spread_home_pheromone(const int& x, const int& y, const int& pheromoneValue, const int& spread);
     void spread_food_pheromone(const int& x, const int& y, const int& pheromoneValue, const int& spread);
+    void merge_deposits(const std::vector<PheromoneDeposits>& deposits, const int& firstTileRow, const int& lastTileRow);
+    void finish_deposits(std::vector<PheromoneDeposits>& deposits);
     void decay_all_pheromones();
     void decay_pheromone_vector(std::vector<int>& pheromonesVector);
+    int decay_pheromone_value(const int& pheromoneValue, const int& decaySteps) const;
+    void apply_pending_decay();
 
+    void build_summed_area_tables();
+    void prepare_summed_area_tables();
+    void build_summed_area_rows(const int& firstRow, const int& lastRow);
+    void build_summed_area_columns(const int& firstColumn, const int& lastColumn);
+    void finish_summed_area_tables();
+    bool are_summed_area_tables_current() const;
+
+    double average_pheromones(const PheromoneChannel& channel, const SensingSide& side, const Vector3D& locationVector, const double& orientation, const int& smellRange) const;
     double average_food_pheromones_right(const Vector3D& locationVector, const double& orientation, const int& smellRange) const;
     double average_food_pheromones_left(const Vector3D& locationVector, const double& orientation, const int& smellRange) const;
     double average_home_pheromones_right(const Vector3D& locationVector, const double& orientation, const int& smellRange) const;
@@ -48,6 +123,63 @@ protected:
     std::vector<int> toFoodPheromones;
     int smellSamplingResolution{1};
     int pheromoneDecayValue{1};
+    DecayKernel decayKernel{get_best_decay_kernel()};
+
+    // The grid is split into square tiles. Every cell outside the active
+    // tiles is zero, so decay, clear and export only visit active tiles.
+    bool decay_tile(const int& tile);
+    bool is_tile_empty(const int& tile) const;
+    void clear_tile(const int& tile);
+    void sweep_lazy_tiles();
+    int get_grid_coordinate(const int& value) const;
+    std::vector<int> export_pheromones(const PheromoneChannel& channel) const;
+
+    int tileSize{32};
+    int tilesWide{0};
+    int tilesHigh{0};
+    std::vector<unsigned char> tileActive;
+    std::vector<int> activeTiles;
+
+    // merge_deposits() runs one tile row per worker, so tiles it activates
+    // are listed per row and appended to activeTiles by finish_deposits().
+    void merge_deposit(const PheromoneDeposit& deposit, const int& tileRow);
+    std::vector<std::vector<int>> rowActivatedTiles;
+    int lazyTileSweepInterval{32};
+
+    // Summed-area tables have one extra leading row and column of zeros. They
+    // are only used while no pheromone has changed since the last build;
+    // otherwise sensing falls back to the exact sampler.
+    double average_exact(const PheromoneChannel& channel, const Vector3D& locationVector, const double& orientation, const double& sideAngle, const int& smellRange) const;
+    double average_summed_area(const std::vector<long long>& sums, const Vector3D& locationVector, const double& orientation, const double& sideAngle, const int& smellRange) const;
+    double average_stencil(const PheromoneChannel& channel, const SensingSide& side, const Vector3D& locationVector, const double& orientation) const;
+    long long get_box_sum(const std::vector<long long>& sums, const int& firstColumn, const int& firstRow, const int& lastColumn, const int& lastRow) const;
+
+    TrigMode trigMode{libmTrig};
+    SensingMode sensingMode{exactSensing};
+    int summedAreaBlocks{3};
+    bool summedAreaTablesDirty{true};
+    std::vector<long long> homeSums;
+    std::vector<long long> foodSums;
+
+    // Stencils are stored flat: stencil (heading*2 + side) holds
+    // stencilSamples offsets starting at that stencil times stencilSamples,
+    // and its bounding box starts at that stencil times four.
+    int stencilSmellRange{0};
+    int stencilHeadings{0};
+    int stencilSamples{0};
+    std::vector<int> stencilColumnOffsets;
+    std::vector<int> stencilRowOffsets;
+    std::vector<int> stencilIndexOffsets;
+    std::vector<int> stencilBounds;
+
+    // Lazy decay: decay_all_pheromones() only advances decayTick, and each
+    // cell catches up on the decay it missed when it is next read or written.
+    int get_pending_decay_steps(const int& index) const;
+    void apply_pending_decay(const int& index);
+
+    bool lazyDecay{false};
+    int decayTick{0};
+    std::vector<int> lastDecayTicks;
 };
 
 #endif // PHEROMONEGRID_HPP
@@ -0,0 +1,96 @@
+#include "randomstreams.hpp"
+
+namespace
+{
+const std::uint64_t pcgMultiplier = 6364136223846793005ULL;
+const std::uint64_t goldenGamma = 0x9E3779B97F4A7C15ULL;
+const double unitScale = 1.0/9007199254740992.0;
+
+inline std::uint64_t mix_bits(std::uint64_t value)
+{
+    value = (value ^ (value >> 30))*0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27))*0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+inline double bits_to_unit(const std::uint64_t& bits)
+{
+    return (bits >> 11)*unitScale;
+}
+}
+
+PcgStream::PcgStream(){}
+
+PcgStream::PcgStream(const std::uint64_t& seed, const std::uint64_t& stream): increment((stream << 1) | 1)
+{
+    next_bits();
+    state += seed;
+    next_bits();
+}
+
+std::uint32_t PcgStream::next_bits()
+{
+    std::uint64_t oldState = state;
+    state = oldState*pcgMultiplier + increment;
+    std::uint32_t shifted = std::uint32_t(((oldState >> 18) ^ oldState) >> 27);
+    std::uint32_t rotation = std::uint32_t(oldState >> 59);
+    return (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+}
+
+double PcgStream::next_unit()
+{
+    std::uint64_t high = next_bits();
+    std::uint64_t low = next_bits();
+    return bits_to_unit((high << 32) | low);
+}
+
+double PcgStream::next_double(const double& minValue, const double& maxValue)
+{
+    return minValue + (maxValue - minValue)*next_unit();
+}
+
+RandomStreams::RandomStreams(){}
+
+RandomStreams::RandomStreams(const std::uint64_t& seed): seed(seed){}
+
+std::uint64_t RandomStreams::get_seed() const
+{
+    return seed;
+}
+
+void RandomStreams::set_seed(const std::uint64_t& newSeed)
+{
+    seed = newSeed;
+}
+
+std::uint64_t RandomStreams::get_bits(const std::uint64_t& stream, const std::uint64_t& counter) const
+{
+    return mix_bits(get_stream_key(stream) + counter*goldenGamma);
+}
+
+double RandomStreams::get_unit(const std::uint64_t& stream, const std::uint64_t& counter) const
+{
+    return bits_to_unit(get_bits(stream, counter));
+}
+
+// The loop body has no dependence between iterations, so the compiler can
+// vectorize it; values[i] is the same as get_unit(stream, firstCounter + i).
+void RandomStreams::fill_unit(const std::uint64_t& stream, const std::uint64_t& firstCounter, double* values, const int& count) const
+{
+    std::uint64_t key = get_stream_key(stream) + firstCounter*goldenGamma;
+    for (int i = 0; i < count; i++)
+    {
+        values[i] = bits_to_unit(mix_bits(key + std::uint64_t(i)*goldenGamma));
+    }
+}
+
+// A sequential generator for serial code, seeded from one counter value.
+PcgStream RandomStreams::make_stream(const std::uint64_t& stream, const std::uint64_t& counter) const
+{
+    return PcgStream(get_bits(stream, counter), stream);
+}
+
+std::uint64_t RandomStreams::get_stream_key(const std::uint64_t& stream) const
+{
+    return mix_bits(seed ^ mix_bits(stream + goldenGamma));
+}
@@ -0,0 +1,49 @@
+#ifndef RANDOMSTREAMS_HPP
+#define RANDOMSTREAMS_HPP
+
+#include <cstdint>
+
+// Sequential PCG32 generator (XSH-RR output). Different stream ids give
+// independent sequences from the same seed, and constructing one costs two
+// multiplies, so it is cheap to make one per worker or per task.
+class PcgStream
+{
+public:
+    PcgStream();
+    PcgStream(const std::uint64_t& seed, const std::uint64_t& stream);
+
+    std::uint32_t next_bits();
+    double next_unit();
+    double next_double(const double& minValue, const double& maxValue);
+
+private:
+    std::uint64_t state{0};
+    std::uint64_t increment{1};
+};
+
+// Counter-based random numbers: each value is a pure function of the master
+// seed, a stream id and a counter (SplitMix64 keyed per stream), so any range
+// of counters can be generated by any thread in any order and still give the
+// same values. This is what lets per-ant rolls be drawn inside the parallel
+// loops without the result depending on how the ants are split.
+class RandomStreams
+{
+public:
+    RandomStreams();
+    RandomStreams(const std::uint64_t& seed);
+
+    std::uint64_t get_seed() const;
+    void set_seed(const std::uint64_t& newSeed);
+
+    std::uint64_t get_bits(const std::uint64_t& stream, const std::uint64_t& counter) const;
+    double get_unit(const std::uint64_t& stream, const std::uint64_t& counter) const;
+    void fill_unit(const std::uint64_t& stream, const std::uint64_t& firstCounter, double* values, const int& count) const;
+    PcgStream make_stream(const std::uint64_t& stream, const std::uint64_t& counter) const;
+
+private:
+    std::uint64_t get_stream_key(const std::uint64_t& stream) const;
+
+    std::uint64_t seed{0};
+};
+
+#endif // RANDOMSTREAMS_HPP
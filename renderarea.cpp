@@ -1,26 +1,33 @@
 #include "renderarea.hpp"
 
-RenderArea::RenderArea(QWidget *parent, World* world)
-    : QWidget{parent}, worldPtr{world}
+#include <algorithm>
+
+RenderArea::RenderArea(QWidget *parent, SimulationWorker* simulation)
+    : QWidget{parent}, simulationPtr{simulation}
 {
     setBackgroundRole(QPalette::Base);
     setAutoFillBackground(true);
 
-    worldWidth = worldPtr->get_width();
-    worldHeight = worldPtr->get_height();
-
-    generate_obstacle_image_vector();
-    initialize_pheromone_images();
+    worldWidth = simulationPtr->get_width();
+    worldHeight = simulationPtr->get_height();
 }
 
+// The snapshot stays untouched by the simulation thread until the next
+// acquire, so it is safe to paint from directly.
 void RenderArea::paintEvent(QPaintEvent* event)
 {
+    const RenderSnapshot& snapshot = simulationPtr->acquire_snapshot();
+    if (snapshot.obstacleRevision != paintedObstacleRevision)
+    {
+        generate_obstacle_image_vector(snapshot);
+    }
+
     QPainter painter(this);
     paint_obstacles(&painter);
-    paint_pheromones(&painter);
-    paint_ants(&painter);
-    paint_food(&painter);
-    paint_colony(&painter);
+    paint_pheromones(&painter, snapshot);
+    paint_ants(&painter, snapshot);
+    paint_food(&painter, snapshot);
+    paint_colony(&painter, snapshot);
 }
 
 void RenderArea::mousePressEvent(QMouseEvent *event)
@@ -33,7 +40,7 @@ void RenderArea::mousePressEvent(QMouseEvent *event)
 
         if (currentAddObject == food)
         {
-            worldPtr->add_food(x,y,100);
+            simulationPtr->post([x, y](World& world) { world.add_food(x,y,100); });
         }
         if (currentAddObject == obstacle)
         {
@@ -49,7 +56,7 @@ void RenderArea::mousePressEvent(QMouseEvent *event)
         }
         if (currentAddObject == colony)
         {
-            worldPtr->add_colony(x,y);
+            simulationPtr->post([x, y](World& world) { world.add_colony(x,y); });
         }
     }
 }
@@ -65,15 +72,15 @@ void RenderArea::mouseMoveEvent(QMouseEvent *event)
         int y2 = currentPoint.y();
         lastPoint = currentPoint;
 
+        int radius = brushRadius;
+
         if (currentAddObject == obstacle)
         {
-            worldPtr->add_obstacle_line(x1,y1,x2,y2,brushRadius);
-            generate_obstacle_image_vector();
+            simulationPtr->post([x1, y1, x2, y2, radius](World& world) { world.add_obstacle_line(x1,y1,x2,y2,radius); });
         }
         if (currentAddObject == erase)
         {
-            worldPtr->erase_line(x1,y1,x2,y2,brushRadius);
-            generate_obstacle_image_vector();
+            simulationPtr->post([x1, y1, x2, y2, radius](World& world) { world.erase_line(x1,y1,x2,y2,radius); });
         }
     }
 }
@@ -83,19 +90,20 @@ void RenderArea::mouseReleaseEvent(QMouseEvent *event)
     scribbling = false;
 }
 
-void RenderArea::paint_ants(QPainter* painter)
+void RenderArea::paint_ants(QPainter* painter, const RenderSnapshot& snapshot)
 {
-    std::vector<Ant> ants = worldPtr->get_ants();
+    const AntPopulation& ants = snapshot.ants;
     for (int i = 0; i < ants.size(); i++)
     {
-        int antX = ants[i].get_location()[0];
-        int antY = ants[i].get_location()[1];
-        double antOrientation = (180.0/M_PI)*ants[i].get_orientation() + 90;
+        Vector3D location = ants.get_location(i);
+        int antX = location[0];
+        int antY = location[1];
+        double antOrientation = (180.0/M_PI)*ants.get_orientation(i) + 90;
         painter->translate(antX,antY);
         painter->rotate(antOrientation);
         QRect antRect{-antSize/2,-antSize/2,antSize,antSize};
 
-        if (ants[i].has_food())
+        if (ants.has_food(i))
         {
             antWithFoodIcon.paint(painter, antRect);
         }
@@ -109,10 +117,10 @@ void RenderArea::paint_ants(QPainter* painter)
     }
 }
 
-void RenderArea::paint_food(QPainter *painter)
+void RenderArea::paint_food(QPainter *painter, const RenderSnapshot& snapshot)
 {
     painter->setBrush(Qt::green);
-    std::vector<Food> foodVector = worldPtr->get_food_vector();
+    const std::vector<Food>& foodVector = snapshot.food;
 
     for (int i = 0; i < foodVector.size(); i++)
     {
@@ -130,12 +138,12 @@ QRect RenderArea::get_food_rect(const int& x, const int& y, const int& quantity)
     return QRect(x-width/2, y - width/2, width, width);
 }
 
-void RenderArea::paint_colony(QPainter *painter)
+void RenderArea::paint_colony(QPainter *painter, const RenderSnapshot& snapshot)
 {
-    if (worldPtr->has_colony())
+    if (snapshot.hasColony)
     {
         painter->setBrush(QBrush("brown"));
-        Vector3D location = worldPtr->get_colony().get_location();
+        Vector3D location = snapshot.colony.get_location();
         int x = location[0];
         int y = location[1];
         QRect colonyRect{x-colonySize/2, y-colonySize/2, colonySize, colonySize};
@@ -143,26 +151,15 @@ void RenderArea::paint_colony(QPainter *painter)
     }
 }
 
-void RenderArea::paint_pheromones(QPainter *painter)
+void RenderArea::paint_pheromones(QPainter *painter, const RenderSnapshot& snapshot)
 {
-    PheromoneGrid pheromones = worldPtr->get_pheromones();
-
-    int width= pheromones.get_grid_width();
-    int height = pheromones.get_grid_height();
-    int intSize = sizeof(int);
-    int numberOfBytesPerWidth{width*intSize};
-
-    generate_home_pheromones_image_vector();
-    generate_food_pheromones_image_vector();
-
-    const uchar* homeImageData = reinterpret_cast<const unsigned char*>(homeImageInts.data());
-    const uchar* foodImageData = reinterpret_cast<const unsigned char*>(foodImageInts.data());
-
-    QImage homeImage{homeImageData,width,height,numberOfBytesPerWidth,QImage::Format_ARGB32};
-    QImage foodImage{foodImageData,width,height,numberOfBytesPerWidth,QImage::Format_ARGB32};
+    int width= snapshot.pheromoneWidth;
+    int height = snapshot.pheromoneHeight;
+    int numberOfBytesPerWidth{width*int(sizeof(std::uint32_t))};
 
-    painter->drawImage(QRect{0,0,worldWidth,worldHeight}, foodImage);
-    painter->drawImage(QRect{0,0,worldWidth,worldHeight}, homeImage);
+    const uchar* pheromoneImageData = reinterpret_cast<const unsigned char*>(snapshot.pheromoneImage.data());
+    QImage pheromoneImage{pheromoneImageData,width,height,numberOfBytesPerWidth,QImage::Format_ARGB32_Premultiplied};
+    painter->drawImage(QRect{0,0,worldWidth,worldHeight}, pheromoneImage);
 }
 
 void RenderArea::paint_obstacles(QPainter* painter)
@@ -177,58 +174,29 @@ void RenderArea::paint_obstacles(QPainter* painter)
     painter->drawImage(QRect{0,0,worldWidth,worldHeight}, obstacleImage);
 }
 
-void RenderArea::generate_obstacle_image_vector()
+void RenderArea::generate_obstacle_image_vector(const RenderSnapshot& snapshot)
 {
-    std::vector<bool> obstacleVector = worldPtr->get_obstacle_vector();
-    obstacleImageInts = std::vector<int>(obstacleVector.size());
+    const std::vector<std::uint64_t>& obstacleWords = snapshot.obstacleWords;
+    int wordsPerRow = snapshot.wordsPerRow;
+    paintedObstacleRevision = snapshot.obstacleRevision;
+    int width = worldWidth+1;
+    int height = worldHeight+1;
+    obstacleImageInts = std::vector<int>(width*height);
     fill(obstacleImageInts.begin(), obstacleImageInts.end(), 0);
 
-    for (int i = 0; i<obstacleVector.size(); i++)
-    {
-        if (obstacleVector[i] == true)
-        {
-            set_rgba_value(obstacleImageInts.data()+i,0,0,0,255);
-        }
-    }
-}
-
-void RenderArea::initialize_pheromone_images()
-{
-    PheromoneGrid pheromones = worldPtr->get_pheromones();
-    int pheromonesLength = pheromones.get_food_pheromones().size();
-    homeImageInts = std::vector<int>(pheromonesLength,0);
-    foodImageInts = std::vector<int>(pheromonesLength,0);
-}
-
-void RenderArea::generate_home_pheromones_image_vector()
-{
-    PheromoneGrid pheromones = worldPtr->get_pheromones();
-    std::vector<int> homeAlphas = pheromones.get_home_pheromones();
-
-    for (int i=0; i < homeAlphas.size(); i++)
-    {
-        int alphaValue = homeAlphas[i]/pheromoneAlphaScale;
-        if (alphaValue>255)
-        {
-            alphaValue = 255;
-        }
-        set_rgba_value(homeImageInts.data()+i,255,0,0,alphaValue);
-    }
-}
-
-void RenderArea::generate_food_pheromones_image_vector()
-{
-    PheromoneGrid pheromones = worldPtr->get_pheromones();
-    std::vector<int> foodAlphas = pheromones.get_food_pheromones();
-
-    for (int i=0; i < foodAlphas.size(); i++)
+    for (int row = 0; row < height; row++)
     {
-        int alphaValue = foodAlphas[i]/pheromoneAlphaScale;
-        if (alphaValue>255)
+        for (int word = 0; word < wordsPerRow; word++)
         {
-            alphaValue = 255;
+            std::uint64_t bits = obstacleWords[row*wordsPerRow + word];
+            for (int bit = 0; bits != 0; bit++, bits >>= 1)
+            {
+                if (bits & 1)
+                {
+                    set_rgba_value(obstacleImageInts.data() + row*width + 64*word + bit,0,0,0,255);
+                }
+            }
         }
-        set_rgba_value(foodImageInts.data()+i,0,0,255,alphaValue);
     }
 }
 
@@ -269,22 +237,22 @@ void RenderArea::add_obstacle(const int &x, const int &y, const QPoint &clickPoi
 {
     scribbling = true;
     lastPoint = clickPoint;
-    worldPtr->add_obstacle(x,y,brushRadius);
-    generate_obstacle_image_vector();
+    int radius = brushRadius;
+    simulationPtr->post([x, y, radius](World& world) { world.add_obstacle(x,y,radius); });
 }
 
 void RenderArea::start_erasing(const int &x, const int &y, const QPoint &clickPoint)
 {
     scribbling = true;
     lastPoint = clickPoint;
-    worldPtr->erase(x,y,brushRadius);
-    generate_obstacle_image_vector();
+    int radius = brushRadius;
+    simulationPtr->post([x, y, radius](World& world) { world.erase(x,y,radius); });
 }
 
 void RenderArea::add_ant(const int &x, const int &y)
 {
     double orientation = generate_random_double(0,2*3.14);
     Vector3D location(x,y,0);
-    worldPtr->add_ant(location, orientation);
+    simulationPtr->post([location, orientation](World& world) { world.add_ant(location, orientation); });
 }
 
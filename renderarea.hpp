@@ -1,7 +1,7 @@
 #ifndef RENDERAREA_HPP
 #define RENDERAREA_HPP
 
-#include "world.hpp"
+#include "simulationworker.hpp"
 
 #include <QObject>
 #include <QWidget>
@@ -15,19 +15,16 @@ class RenderArea : public QWidget
 {
     Q_OBJECT
 public:
-    explicit RenderArea(QWidget *parent = nullptr, World* world = nullptr);
+    explicit RenderArea(QWidget *parent = nullptr, SimulationWorker* simulation = nullptr);
 
-    void paint_ants(QPainter* painter);
-    void paint_food(QPainter* painter);
-    void paint_colony(QPainter* painter);
-    void paint_pheromones(QPainter* painter);
+    void paint_ants(QPainter* painter, const RenderSnapshot& snapshot);
+    void paint_food(QPainter* painter, const RenderSnapshot& snapshot);
+    void paint_colony(QPainter* painter, const RenderSnapshot& snapshot);
+    void paint_pheromones(QPainter* painter, const RenderSnapshot& snapshot);
     void paint_obstacles(QPainter* painter);
     QRect get_food_rect(const int& x, const int& y, const int& quantity);
 
-    void generate_obstacle_image_vector();
-    void initialize_pheromone_images();
-    void generate_home_pheromones_image_vector();
-    void generate_food_pheromones_image_vector();
+    void generate_obstacle_image_vector(const RenderSnapshot& snapshot);
     void set_rgba_value(int* pixel, unsigned char red, unsigned char green, unsigned char blue, unsigned char alpha);
 
     void set_currentAddObject(const int& object);
@@ -47,9 +44,8 @@ protected:
     QTimer *timer{nullptr};
     QIcon antIcon = QIcon(":myicons/ant image2.png");
     QIcon antWithFoodIcon = QIcon(":myicons/ant with food image.png");
-    std::vector<int> homeImageInts;
-    std::vector<int> foodImageInts;
     std::vector<int> obstacleImageInts;
+    long long paintedObstacleRevision{-1};
 
     enum AddObject { food = 1, obstacle = 2, ant = 3, erase = 4, colony = 5};
     AddObject currentAddObject{food};
@@ -62,10 +58,9 @@ protected:
     int colonySize{30};
     int worldWidth;
     int worldHeight;
-    int pheromoneAlphaScale{30};
     int brushRadius{15};
 
-    World* worldPtr;
+    SimulationWorker* simulationPtr;
 
     QImage antImage = QImage(":myicons/ant image2.png");
 };
@@ -0,0 +1,147 @@
+#include "rendersnapshot.hpp"
+
+#include <algorithm>
+
+const int RenderSnapshot::pheromoneAlphaScale = 30;
+
+namespace
+{
+// A channel's alpha is its value/pheromoneAlphaScale, capped at 255. For
+// values up to the cap, multiplying by this rounded-up reciprocal and
+// shifting gives the same quotient without a divide.
+const int alphaShift = 20;
+const std::uint32_t alphaCap = 255*RenderSnapshot::pheromoneAlphaScale;
+const std::uint32_t alphaReciprocal = ((1u << alphaShift) + RenderSnapshot::pheromoneAlphaScale - 1)/RenderSnapshot::pheromoneAlphaScale;
+
+inline std::uint32_t get_pheromone_alpha(const int& pheromone)
+{
+    std::uint32_t value = pheromone < 0 ? 0 : std::min(std::uint32_t(pheromone), alphaCap);
+    return (value*alphaReciprocal) >> alphaShift;
+}
+
+// Rounded value/255 for value <= 255*255.
+inline std::uint32_t divide_by_255(const std::uint32_t& value)
+{
+    return (value + 128 + ((value + 128) >> 8)) >> 8;
+}
+
+// Kept free of calls and branches so the compiler can vectorize the loop.
+void compose_pheromone_row(const int* homeCells, const int* foodCells, std::uint32_t* pixels, const int& count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        pixels[i] = RenderSnapshot::compose_pheromone_pixel(homeCells[i], foodCells[i]);
+    }
+}
+}
+
+void RenderSnapshot::capture(const World& world, const long long& tick, const long long& revision)
+{
+    ticks = tick;
+    width = world.get_width();
+    height = world.get_height();
+    ants = world.view_ants();
+    ConstSpan<Food> foodView = world.view_food();
+    food.assign(foodView.begin(), foodView.end());
+    hasColony = world.has_colony();
+    colony = world.view_colony();
+
+    const PheromoneGrid& pheromones = world.view_pheromones();
+    if (pheromoneImage.size() != pheromones.get_cell_count())
+    {
+        pheromoneImage.assign(pheromones.get_cell_count(), 0);
+        paintedTiles.clear();
+    }
+    pheromoneWidth = pheromones.get_grid_width();
+    pheromoneHeight = pheromones.get_grid_height();
+    for (int i = 0; i < paintedTiles.size(); i++)
+    {
+        compose_pheromone_tile(pheromones, paintedTiles[i]);
+    }
+    const std::vector<int>& activeTiles = pheromones.get_active_tiles();
+    for (int i = 0; i < activeTiles.size(); i++)
+    {
+        compose_pheromone_tile(pheromones, activeTiles[i]);
+    }
+    paintedTiles = activeTiles;
+
+    if (obstacleRevision != revision)
+    {
+        const ObstacleGrid& obstacles = world.view_obstacles();
+        obstacleWords = obstacles.get_obstacle_words();
+        wordsPerRow = obstacles.get_words_per_row();
+        obstacleRevision = revision;
+    }
+}
+
+// Under lazy decay the stored values may still owe decay. Decay never raises
+// a value, so a cell whose stored values are already below one alpha step is
+// transparent without working out the decay.
+void RenderSnapshot::compose_pheromone_tile(const PheromoneGrid& pheromones, const int& tile)
+{
+    int firstColumn, firstRow, lastColumn, lastRow;
+    pheromones.get_tile_bounds(tile, firstColumn, firstRow, lastColumn, lastRow);
+    const int* homeCells = pheromones.view_home_pheromones().data();
+    const int* foodCells = pheromones.view_food_pheromones().data();
+    bool lazyDecay = pheromones.is_lazy_decay_enabled();
+
+    for (int row = firstRow; row < lastRow; row++)
+    {
+        int first = row*pheromoneWidth + firstColumn;
+        int last = row*pheromoneWidth + lastColumn;
+        if (!lazyDecay)
+        {
+            compose_pheromone_row(homeCells + first, foodCells + first, pheromoneImage.data() + first, last - first);
+            continue;
+        }
+        for (int i = first; i < last; i++)
+        {
+            if (homeCells[i] < pheromoneAlphaScale && foodCells[i] < pheromoneAlphaScale)
+            {
+                pheromoneImage[i] = 0;
+            }
+            else
+            {
+                pheromoneImage[i] = compose_pheromone_pixel(pheromones.get_home_pheromone_at(i), pheromones.get_food_pheromone_at(i));
+            }
+        }
+    }
+}
+
+// Home is blue and food red, matching the colours the two separate images
+// used to draw. Premultiplied, home over food is:
+//   blue = homeAlpha, red = foodAlpha*(255 - homeAlpha)/255, alpha = blue + red.
+std::uint32_t RenderSnapshot::compose_pheromone_pixel(const int& homePheromone, const int& foodPheromone)
+{
+    std::uint32_t homeAlpha = get_pheromone_alpha(homePheromone);
+    std::uint32_t foodShown = divide_by_255(get_pheromone_alpha(foodPheromone)*(255 - homeAlpha));
+    return (homeAlpha + foodShown) << 24 | foodShown << 16 | homeAlpha;
+}
+
+SnapshotBuffer::SnapshotBuffer() : middle(1)
+{
+}
+
+RenderSnapshot& SnapshotBuffer::get_back()
+{
+    return slots[back];
+}
+
+void SnapshotBuffer::publish()
+{
+    back = middle.exchange(back | freshBit, std::memory_order_acq_rel) & slotMask;
+}
+
+const RenderSnapshot& SnapshotBuffer::acquire()
+{
+    if (has_new_snapshot())
+    {
+        front = middle.exchange(front, std::memory_order_acq_rel) & slotMask;
+    }
+    return slots[front];
+}
+
+bool SnapshotBuffer::has_new_snapshot() const
+{
+    return (middle.load(std::memory_order_acquire) & freshBit) != 0;
+}
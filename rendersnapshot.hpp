@@ -0,0 +1,67 @@
+#ifndef RENDERSNAPSHOT_HPP
+#define RENDERSNAPSHOT_HPP
+
+#include "world.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Everything RenderArea draws, copied out of a World between ticks so the GUI
+// never reads the World while the simulation thread is changing it.
+// Both pheromone channels are composed into one premultiplied ARGB32 image,
+// home drawn over food, and only for tiles that are active now or were
+// active when this snapshot was last captured. Obstacle words are only
+// copied when editRevision has moved on.
+struct RenderSnapshot
+{
+    void capture(const World& world, const long long& tick, const long long& revision);
+    void compose_pheromone_tile(const PheromoneGrid& pheromones, const int& tile);
+    static std::uint32_t compose_pheromone_pixel(const int& homePheromone, const int& foodPheromone);
+
+    static const int pheromoneAlphaScale;
+
+    long long ticks{0};
+    int width{0};
+    int height{0};
+    AntPopulation ants;
+    std::vector<Food> food;
+    bool hasColony{false};
+    Colony colony;
+
+    int pheromoneWidth{0};
+    int pheromoneHeight{0};
+    std::vector<std::uint32_t> pheromoneImage;
+    std::vector<int> paintedTiles;
+
+    long long obstacleRevision{-1};
+    int wordsPerRow{0};
+    std::vector<std::uint64_t> obstacleWords;
+};
+
+// Triple buffer handing snapshots from one writer thread to one reader
+// thread. The writer fills get_back() and publish() swaps it with the shared
+// middle slot; acquire() takes the middle slot if it is newer than the one
+// the reader holds. Neither side waits, and the slot the reader holds is not
+// touched until its next acquire().
+class SnapshotBuffer
+{
+public:
+    SnapshotBuffer();
+
+    RenderSnapshot& get_back();
+    void publish();
+    const RenderSnapshot& acquire();
+    bool has_new_snapshot() const;
+
+private:
+    static const int slotMask = 3;
+    static const int freshBit = 4;
+
+    RenderSnapshot slots[3];
+    std::atomic<int> middle;
+    int back{0};
+    int front{2};
+};
+
+#endif // RENDERSNAPSHOT_HPP
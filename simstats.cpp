@@ -0,0 +1,121 @@
+#include "simstats.hpp"
+
+#include <algorithm>
+
+#ifdef ANTSIM_STATS
+thread_local long long threadStatCounters[statCounterCount];
+#endif
+
+const int StatsRecorder::statsWindow = 64;
+
+const char* get_update_phase_name(const UpdatePhase& phase)
+{
+    static const char* names[updatePhaseCount] = {"move", "turn", "deposit", "decay", "collect", "drop", "diminish", "reset"};
+    return phase >= 0 && phase < updatePhaseCount ? names[phase] : "unknown";
+}
+
+const char* get_stat_counter_name(const StatCounter& counter)
+{
+    static const char* names[statCounterCount] = {"pheromone samples", "ray cell tests", "ray row scans", "food pickups", "food drops"};
+    return counter >= 0 && counter < statCounterCount ? names[counter] : "unknown";
+}
+
+StatsRecorder::StatsRecorder()
+{
+    set_worker_count(1);
+    clear();
+}
+
+void StatsRecorder::set_worker_count(const int& workerCount)
+{
+    workerCounters.resize(std::max(workerCount, 1)*statCounterCount, 0);
+}
+
+// Drops whatever the calling thread tallied outside a recorded phase, such as
+// a direct call to collect_food().
+void StatsRecorder::discard_thread_counters()
+{
+#ifdef ANTSIM_STATS
+    std::fill(threadStatCounters, threadStatCounters + statCounterCount, 0);
+#endif
+}
+
+// Each worker writes only its own slot, so this is safe inside parallel_for.
+void StatsRecorder::collect_thread_counters(const int& worker)
+{
+#ifdef ANTSIM_STATS
+    long long* slot = workerCounters.data() + worker*statCounterCount;
+    for (int i = 0; i < statCounterCount; i++)
+    {
+        slot[i] += threadStatCounters[i];
+        threadStatCounters[i] = 0;
+    }
+#else
+    (void)worker;
+#endif
+}
+
+void StatsRecorder::finish_phase(const UpdatePhase& phase, const double& milliseconds)
+{
+    currentTick.phaseMilliseconds[phase] += milliseconds;
+    for (int i = 0; i < workerCounters.size(); i++)
+    {
+        currentTick.counters[i % statCounterCount] += workerCounters[i];
+        workerCounters[i] = 0;
+    }
+}
+
+void StatsRecorder::finish_tick()
+{
+    for (int i = 0; i < statCounterCount; i++)
+    {
+        totalCounters[i] += currentTick.counters[i];
+    }
+    if (window.size() < statsWindow)
+    {
+        window.push_back(currentTick);
+    }
+    else
+    {
+        window[ticks % statsWindow] = currentTick;
+    }
+    ticks++;
+    currentTick = TickRecord();
+}
+
+void StatsRecorder::clear()
+{
+    window.clear();
+    std::fill(workerCounters.begin(), workerCounters.end(), 0);
+    currentTick = TickRecord();
+    std::fill(totalCounters, totalCounters + statCounterCount, 0);
+    ticks = 0;
+}
+
+SimulationStats StatsRecorder::get_snapshot() const
+{
+    SimulationStats stats = SimulationStats();
+    stats.ticks = ticks;
+    stats.averagedTicks = window.size();
+    std::copy(totalCounters, totalCounters + statCounterCount, stats.totalCounters);
+    if (window.empty())
+    {
+        return stats;
+    }
+
+    const TickRecord& last = window[(ticks - 1) % statsWindow];
+    std::copy(last.phaseMilliseconds, last.phaseMilliseconds + updatePhaseCount, stats.lastPhaseMilliseconds);
+    std::copy(last.counters, last.counters + statCounterCount, stats.lastCounters);
+    for (int tick = 0; tick < window.size(); tick++)
+    {
+        for (int i = 0; i < updatePhaseCount; i++)
+        {
+            stats.averagePhaseMilliseconds[i] += window[tick].phaseMilliseconds[i]/window.size();
+        }
+        for (int i = 0; i < statCounterCount; i++)
+        {
+            stats.averageCounters[i] += double(window[tick].counters[i])/window.size();
+        }
+    }
+    return stats;
+}
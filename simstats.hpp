@@ -0,0 +1,71 @@
+#ifndef SIMSTATS_HPP
+#define SIMSTATS_HPP
+
+#include <vector>
+
+// The steps of one World::update(), in the order they run.
+enum UpdatePhase { movePhase, turnPhase, depositPhase, decayPhase, collectPhase, dropPhase, diminishPhase, resetPhase, updatePhaseCount };
+
+// pheromoneSamples counts the values the sensors read: cells for the exact and
+// stencil samplers, boxes for the summed-area one. rayCellTests counts obstacle
+// cells tested one at a time, including each distance-field lookup, and
+// rayRowScans counts the word-at-a-time scans along a row.
+enum StatCounter { pheromoneSamplesCounter, rayCellTestsCounter, rayRowScansCounter, foodPickupsCounter, foodDropsCounter, statCounterCount };
+
+const char* get_update_phase_name(const UpdatePhase& phase);
+const char* get_stat_counter_name(const StatCounter& counter);
+
+// Hot code tallies into the calling thread's counters; the World moves them
+// into its StatsRecorder when each phase or parallel range ends. Building
+// without ANTSIM_STATS removes the tallies and the phase timing entirely.
+#ifdef ANTSIM_STATS
+extern thread_local long long threadStatCounters[statCounterCount];
+#define ANTSIM_COUNT(counter, amount) (threadStatCounters[counter] += (amount))
+#else
+#define ANTSIM_COUNT(counter, amount) ((void)sizeof(amount))
+#endif
+
+struct SimulationStats
+{
+    long long ticks;
+    int averagedTicks;
+    double lastPhaseMilliseconds[updatePhaseCount];
+    double averagePhaseMilliseconds[updatePhaseCount];
+    long long lastCounters[statCounterCount];
+    double averageCounters[statCounterCount];
+    long long totalCounters[statCounterCount];
+};
+
+// Keeps the last statsWindow ticks so the averages follow the current load
+// rather than the whole run.
+class StatsRecorder
+{
+public:
+    StatsRecorder();
+
+    void set_worker_count(const int& workerCount);
+    void discard_thread_counters();
+    void collect_thread_counters(const int& worker);
+    void finish_phase(const UpdatePhase& phase, const double& milliseconds);
+    void finish_tick();
+    void clear();
+
+    SimulationStats get_snapshot() const;
+
+    static const int statsWindow;
+
+private:
+    struct TickRecord
+    {
+        double phaseMilliseconds[updatePhaseCount];
+        long long counters[statCounterCount];
+    };
+
+    std::vector<TickRecord> window;
+    std::vector<long long> workerCounters;
+    TickRecord currentTick;
+    long long totalCounters[statCounterCount];
+    long long ticks{0};
+};
+
+#endif // SIMSTATS_HPP
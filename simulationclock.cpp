@@ -0,0 +1,131 @@
+#include "simulationclock.hpp"
+
+const int SimulationClock::maxCatchUpTicks = 8;
+const SimulationClock::Clock::duration SimulationClock::publishInterval = std::chrono::milliseconds(8);
+const SimulationClock::Clock::duration SimulationClock::turboPublishInterval = std::chrono::milliseconds(100);
+const SimulationClock::Clock::duration SimulationClock::fastForwardPublishInterval = std::chrono::milliseconds(500);
+const SimulationClock::Clock::duration SimulationClock::idlePollInterval = std::chrono::milliseconds(10);
+
+SimulationClock::SimulationClock()
+{
+}
+
+int SimulationClock::get_target_ticks_per_second() const
+{
+    return targetTicksPerSecond;
+}
+
+void SimulationClock::set_target_ticks_per_second(const int& ticksPerSecond)
+{
+    targetTicksPerSecond = ticksPerSecond < 0 ? 0 : ticksPerSecond;
+}
+
+bool SimulationClock::is_turbo() const
+{
+    return turbo;
+}
+
+void SimulationClock::set_turbo(const bool& enabled)
+{
+    turbo = enabled;
+}
+
+// Adds to any fast-forward still running.
+void SimulationClock::fast_forward(const long long& tickCount)
+{
+    if (tickCount > 0)
+    {
+        fastForwardRemaining += tickCount;
+    }
+}
+
+long long SimulationClock::get_fast_forward_remaining() const
+{
+    return fastForwardRemaining;
+}
+
+int SimulationClock::ticks_due(const Clock::time_point& now)
+{
+    if (fastForwardRemaining > 0)
+    {
+        if (--fastForwardRemaining == 0)
+        {
+            fastForwardFinished = true;
+            resumePacing = true;
+        }
+        return 1;
+    }
+    if (turbo)
+    {
+        resumePacing = true;
+        return 1;
+    }
+
+    int ticksPerSecond = targetTicksPerSecond;
+    if (ticksPerSecond == 0)
+    {
+        resumePacing = true;
+        return 0;
+    }
+    Clock::duration tickPeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0/ticksPerSecond));
+    if (resumePacing || ticksPerSecond != pacedTicksPerSecond)
+    {
+        nextTick = now;
+        pacedTicksPerSecond = ticksPerSecond;
+        resumePacing = false;
+    }
+    if (now < nextTick)
+    {
+        return 0;
+    }
+
+    int dueTicks = int((now - nextTick)/tickPeriod) + 1;
+    if (dueTicks > maxCatchUpTicks)
+    {
+        dueTicks = maxCatchUpTicks;
+        nextTick = now + tickPeriod;
+    }
+    else
+    {
+        nextTick += dueTicks*tickPeriod;
+    }
+    return dueTicks;
+}
+
+bool SimulationClock::should_publish(const Clock::time_point& now)
+{
+    Clock::duration interval = publishInterval;
+    if (fastForwardFinished)
+    {
+        fastForwardFinished = false;
+        interval = Clock::duration::zero();
+    }
+    else if (fastForwardRemaining > 0)
+    {
+        interval = fastForwardPublishInterval;
+    }
+    else if (turbo)
+    {
+        interval = turboPublishInterval;
+    }
+
+    if (now - lastPublish < interval)
+    {
+        return false;
+    }
+    lastPublish = now;
+    return true;
+}
+
+// When nothing is due, how long the loop may sleep. It still wakes every
+// idlePollInterval so posted edits and setting changes are not held up by a
+// slow tick rate or a pause.
+SimulationClock::Clock::time_point SimulationClock::get_wake_time(const Clock::time_point& now) const
+{
+    Clock::time_point pollTime = now + idlePollInterval;
+    if (resumePacing || targetTicksPerSecond == 0 || nextTick > pollTime)
+    {
+        return pollTime;
+    }
+    return nextTick;
+}
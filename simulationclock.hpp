@@ -0,0 +1,53 @@
+#ifndef SIMULATIONCLOCK_HPP
+#define SIMULATIONCLOCK_HPP
+
+#include <atomic>
+#include <chrono>
+
+// Decides when the simulation thread ticks and when it publishes a snapshot.
+// At a fixed rate, ticks are due every 1/targetTicksPerSecond and a loop that
+// falls behind runs up to maxCatchUpTicks at once before dropping the rest of
+// the backlog; a target of zero pauses. Turbo ticks back to back and only
+// publishes every turboPublishInterval. A fast-forward runs its ticks back to
+// back before anything else, publishes only progress, then resumes the
+// previous mode from the current time.
+//
+// The settings may be changed from any thread; ticks_due(), should_publish()
+// and get_wake_time() belong to the simulation thread.
+class SimulationClock
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    SimulationClock();
+
+    int get_target_ticks_per_second() const;
+    void set_target_ticks_per_second(const int& ticksPerSecond);
+    bool is_turbo() const;
+    void set_turbo(const bool& enabled);
+    void fast_forward(const long long& tickCount);
+    long long get_fast_forward_remaining() const;
+
+    int ticks_due(const Clock::time_point& now);
+    bool should_publish(const Clock::time_point& now);
+    Clock::time_point get_wake_time(const Clock::time_point& now) const;
+
+    static const int maxCatchUpTicks;
+    static const Clock::duration publishInterval;
+    static const Clock::duration turboPublishInterval;
+    static const Clock::duration fastForwardPublishInterval;
+    static const Clock::duration idlePollInterval;
+
+private:
+    std::atomic<int> targetTicksPerSecond{100};
+    std::atomic<bool> turbo{false};
+    std::atomic<long long> fastForwardRemaining{0};
+
+    Clock::time_point nextTick;
+    Clock::time_point lastPublish;
+    int pacedTicksPerSecond{0};
+    bool resumePacing{true};
+    bool fastForwardFinished{false};
+};
+
+#endif // SIMULATIONCLOCK_HPP
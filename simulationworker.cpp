@@ -0,0 +1,102 @@
+#include "simulationworker.hpp"
+
+#include <QtConcurrent/QtConcurrent>
+
+#include <thread>
+
+SimulationWorker::SimulationWorker(const int& worldWidth, const int& worldHeight)
+    : world{worldWidth, worldHeight}
+{
+    publish_snapshot();
+}
+
+SimulationWorker::~SimulationWorker()
+{
+    stop();
+}
+
+// The loop holds one thread of the global QThreadPool for as long as it runs.
+void SimulationWorker::start()
+{
+    if (running.exchange(true))
+    {
+        return;
+    }
+    loop = QtConcurrent::run([this]() { run(); });
+}
+
+void SimulationWorker::stop()
+{
+    running = false;
+    loop.waitForFinished();
+}
+
+bool SimulationWorker::is_running() const
+{
+    return running;
+}
+
+void SimulationWorker::post(const WorldCommand& command)
+{
+    commands.post(command);
+}
+
+const RenderSnapshot& SimulationWorker::acquire_snapshot()
+{
+    return snapshots.acquire();
+}
+
+int SimulationWorker::get_width() const
+{
+    return world.get_width();
+}
+
+int SimulationWorker::get_height() const
+{
+    return world.get_height();
+}
+
+long long SimulationWorker::get_tick_count() const
+{
+    return ticks;
+}
+
+SimulationClock& SimulationWorker::get_clock()
+{
+    return clock;
+}
+
+void SimulationWorker::run()
+{
+    while (running)
+    {
+        bool edited = commands.run_pending(world) > 0;
+        if (edited)
+        {
+            editRevision++;
+        }
+
+        int dueTicks = clock.ticks_due(SimulationClock::Clock::now());
+        for (int tick = 0; tick < dueTicks; tick++)
+        {
+            world.update();
+            ticks++;
+        }
+
+        SimulationClock::Clock::time_point now = SimulationClock::Clock::now();
+        if ((dueTicks > 0 && clock.should_publish(now)) || edited)
+        {
+            publish_snapshot();
+        }
+        if (dueTicks == 0)
+        {
+            std::this_thread::sleep_until(clock.get_wake_time(now));
+        }
+    }
+}
+
+void SimulationWorker::publish_snapshot()
+{
+    snapshots.get_back().capture(world, ticks, editRevision);
+    snapshots.publish();
+}
@@ -0,0 +1,49 @@
+#ifndef SIMULATIONWORKER_HPP
+#define SIMULATIONWORKER_HPP
+
+#include "world.hpp"
+#include "rendersnapshot.hpp"
+#include "simulationclock.hpp"
+#include "worldcommands.hpp"
+
+#include <QFuture>
+
+#include <atomic>
+
+// Owns the World and runs it on a QtConcurrent thread, so the tick rate no
+// longer depends on the repaint rate. The GUI reads the World only through
+// acquire_snapshot(), changes it only through post(), and sets the pace
+// through get_clock().
+class SimulationWorker
+{
+public:
+    SimulationWorker(const int& worldWidth, const int& worldHeight);
+    ~SimulationWorker();
+
+    void start();
+    void stop();
+    bool is_running() const;
+
+    void post(const WorldCommand& command);
+    const RenderSnapshot& acquire_snapshot();
+
+    int get_width() const;
+    int get_height() const;
+    long long get_tick_count() const;
+    SimulationClock& get_clock();
+
+private:
+    void run();
+    void publish_snapshot();
+
+    World world;
+    WorldCommandQueue commands;
+    SnapshotBuffer snapshots;
+    SimulationClock clock;
+    QFuture<void> loop;
+    std::atomic<bool> running{false};
+    std::atomic<long long> ticks{0};
+    long long editRevision{0};
+};
+
+#endif // SIMULATIONWORKER_HPP
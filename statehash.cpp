@@ -0,0 +1,17 @@
+#include "statehash.hpp"
+
+#include <cstring>
+
+// One rotate, xor and multiply per value keeps hashing a large grid cheap;
+// the hash only has to tell states apart, not resist attacks.
+std::uint64_t hash_value(const std::uint64_t& hash, const std::uint64_t& value)
+{
+    return (((hash << 5) | (hash >> 59)) ^ value)*0x517CC1B727220A95ULL;
+}
+
+std::uint64_t hash_double(const std::uint64_t& hash, const double& value)
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return hash_value(hash, bits);
+}
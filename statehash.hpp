@@ -0,0 +1,15 @@
+#ifndef STATEHASH_HPP
+#define STATEHASH_HPP
+
+#include <cstdint>
+
+// Order-sensitive 64-bit hashing for comparing simulation states. Doubles are
+// hashed by their bit patterns, so runs only hash equal when every value is
+// byte-identical.
+
+const std::uint64_t initialStateHash = 0x84222325CBF29CE4ULL;
+
+std::uint64_t hash_value(const std::uint64_t& hash, const std::uint64_t& value);
+std::uint64_t hash_double(const std::uint64_t& hash, const double& value);
+
+#endif // STATEHASH_HPP
@@ -3,13 +3,24 @@
 #include "gtest/gtest.h"
 #include "vector3D.hpp"
 #include "ant.hpp"
+#include "antpopulation.hpp"
 #include "world.hpp"
 #include "colony.hpp"
 #include "food.hpp"
 #include "pheromonegrid.hpp"
+#include "pheromonedeposits.hpp"
+#include "pheromonedecay.hpp"
+#include "fastmath.hpp"
 #include "obstaclegrid.hpp"
+#include "randomstreams.hpp"
+#include "rendersnapshot.hpp"
+#include "simulationclock.hpp"
+#include "workerpool.hpp"
+#include "worldcommands.hpp"
 
 #include <iostream>
+#include <random>
+#include <thread>
 
 
 //#################################################################
@@ -394,6 +405,112 @@ TEST(GetAngleToPoint, GivenTwoLocationsInVerticalLine_AfterCalculatingAngleBetwe
     EXPECT_NEAR(angle,goldAngle,0.1);
 }
 
+//#################################################################
+//AntPopulation Tests
+//#################################################################
+
+TEST(AntPopulationAddAnt, AfterAddingAnAnt_WhenGettingAntView_ExpectProperValues)
+{
+    AntPopulation testPopulation;
+    Vector3D goldLocation{3,4,0};
+    double goldOrientation{1.5};
+
+    testPopulation.add_ant(goldLocation, goldOrientation);
+    Ant testAnt = testPopulation.get_ant(0);
+
+    EXPECT_EQ(testPopulation.size(), 1);
+    EXPECT_EQ(testAnt.get_location(), goldLocation);
+    EXPECT_EQ(testAnt.get_orientation(), goldOrientation);
+    EXPECT_FALSE(testAnt.has_food());
+}
+
+TEST(AntPopulationHasFood, GivenMoreThanSixtyFourAnts_AfterSettingHasFood_ExpectOnlyThoseAntsHaveFood)
+{
+    AntPopulation testPopulation;
+    for (int i = 0; i < 130; i++)
+    {
+        testPopulation.add_ant(Vector3D(i,i,0), 0);
+    }
+
+    testPopulation.set_has_food(63, true);
+    testPopulation.set_has_food(64, true);
+    testPopulation.set_has_food(129, true);
+
+    for (int i = 0; i < testPopulation.size(); i++)
+    {
+        bool goldHasFood = (i == 63 || i == 64 || i == 129);
+        EXPECT_EQ(testPopulation.has_food(i), goldHasFood);
+    }
+}
+
+TEST(AntPopulationRemoveAnt, GivenAntsWithFood_AfterRemovingAnAnt_ExpectRemainingAntsKeepOrderAndFood)
+{
+    AntPopulation testPopulation;
+    for (int i = 0; i < 70; i++)
+    {
+        testPopulation.add_ant(Vector3D(i,0,0), i);
+    }
+    testPopulation.set_has_food(65, true);
+
+    testPopulation.remove_ant(2);
+
+    EXPECT_EQ(testPopulation.size(), 69);
+    EXPECT_EQ(testPopulation.get_location(2)[0], 3);
+    EXPECT_EQ(testPopulation.get_orientation(68), 69);
+    EXPECT_TRUE(testPopulation.has_food(64));
+    EXPECT_FALSE(testPopulation.has_food(65));
+}
+
+TEST(AntPopulationRemoveAnt, GivenAntsAlongALine_AfterRemovingTheAntsNearASegment_ExpectTheRestKeepOrderAndFood)
+{
+    AntPopulation testPopulation;
+    for (int i = 0; i < 140; i++)
+    {
+        testPopulation.add_ant(Vector3D(i,0,0), i);
+        testPopulation.set_has_food(i, i % 3 == 0);
+    }
+    std::vector<bool> marked;
+
+    testPopulation.mark_ants_near_segment(Vector3D(10,-5,0), Vector3D(20,5,0), 3, marked);
+    testPopulation.mark_ants_near_segment(Vector3D(100,0,0), Vector3D(100,0,0), 2.5, marked);
+    int removed = testPopulation.remove_marked_ants(marked);
+
+    std::vector<int> goldIndices;
+    for (int i = 0; i < 140; i++)
+    {
+        bool nearSegment = i > 15 - 3*sqrt(2.0) && i < 15 + 3*sqrt(2.0);
+        if (!nearSegment && abs(i - 100) > 2)
+        {
+            goldIndices.push_back(i);
+        }
+    }
+    EXPECT_EQ(removed, 140 - goldIndices.size());
+    ASSERT_EQ(testPopulation.size(), goldIndices.size());
+    for (int i = 0; i < goldIndices.size(); i++)
+    {
+        EXPECT_EQ(testPopulation.get_orientation(i), goldIndices[i]);
+        EXPECT_EQ(testPopulation.has_food(i), goldIndices[i] % 3 == 0);
+    }
+    EXPECT_EQ(testPopulation.get_has_food_bits().size(), (goldIndices.size() + 63)/64);
+}
+
+TEST(AntPopulationSetAnt, AfterStoringAnAntView_WhenGettingAntView_ExpectStoredValues)
+{
+    AntPopulation testPopulation;
+    testPopulation.add_ant(Vector3D(0,0,0), 0);
+    Ant testAnt{Vector3D(7,8,0), 2};
+    testAnt.set_has_food(true);
+    testAnt.set_pheromone_strength(55);
+
+    testPopulation.set_ant(0, testAnt);
+    Ant storedAnt = testPopulation.get_ant(0);
+
+    EXPECT_EQ(storedAnt.get_location(), Vector3D(7,8,0));
+    EXPECT_EQ(storedAnt.get_orientation(), 2);
+    EXPECT_TRUE(storedAnt.has_food());
+    EXPECT_EQ(storedAnt.get_pheromone_strength(), 55);
+}
+
 //#################################################################
 //World Tests
 //#################################################################
@@ -591,14 +708,14 @@ public:
 
         add_ant(Vector3D(5,5,0), 0);
         add_ant(Vector3D(50,50,0), 0);
-        ants[1].set_has_food(true);
+        ants.set_has_food(1, true);
 
         indexAnt5 = pheromones.get_index(5,5);
         indexAnt50 = pheromones.get_index(50,50);
     }
     int indexAnt5;
     int indexAnt50;
-    std::vector<Ant>* get_ants_pointer(){return &ants;}
+    AntPopulation* get_ants_pointer(){return &ants;}
     PheromoneGrid* get_pheromone_grid_pointer(){return &pheromones;}
 };
 
@@ -666,6 +783,21 @@ TEST(ErasingLine, GivenAPreBuiltWorldWithAntAndFoodAndObstacles_AfterErasingLine
     EXPECT_FALSE(testWorld.get_obstacles().check_obstacle(x,y));
 }
 
+TEST(ErasingLine, GivenADenseTrailOfAnts_AfterErasingAlongIt_ExpectEveryAntOnTheTrailRemoved)
+{
+    World testWorld{500,500};
+    for (int i = 0; i < 2000; i++)
+    {
+        testWorld.add_ant(Vector3D(100 + i*0.1,100,0),0);
+    }
+    testWorld.add_ant(Vector3D(400,400,0),0);
+
+    testWorld.erase_line(90,100,310,100,5);
+
+    ASSERT_EQ(testWorld.get_ants().size(), 1);
+    EXPECT_EQ(testWorld.get_ants()[0].get_location()[0], 400);
+}
+
 TEST(ErasingLine, GivenAPreBuiltWorldWithAntAndFoodAndObstacles_AfterErasingLineWithSlopeNegativeOne_ExpectNoMoreAntFoodOrObstacles)
 {
     World testWorld{500,500};
@@ -698,6 +830,615 @@ TEST(ClearAll, GivenAPreBuiltWorldWithAntAndFoodAndObstacles_AfterClearingAll_Ex
     EXPECT_FALSE(testWorld.get_obstacles().check_obstacle(x,y));
 }
 
+TEST(ParallelTurning, GivenTwoWorldsWithTheSameSeed_AfterUpdatingWithOneAndFourThreads_ExpectIdenticalAnts)
+{
+    World serialWorld{400,300};
+    World parallelWorld{400,300};
+    serialWorld.set_random_seed(11);
+    parallelWorld.set_random_seed(11);
+    serialWorld.set_thread_count(1);
+    parallelWorld.set_thread_count(4);
+    for (World* world : {&serialWorld, &parallelWorld})
+    {
+        world->add_obstacle_line(100,50,100,250,5);
+        world->add_food(150,150,100);
+        world->add_colony(200,150);
+    }
+
+    for (int tick = 0; tick < 40; tick++)
+    {
+        serialWorld.update();
+        parallelWorld.update();
+    }
+
+    std::vector<Ant> serialAnts = serialWorld.get_ants();
+    std::vector<Ant> parallelAnts = parallelWorld.get_ants();
+    ASSERT_EQ(serialAnts.size(), parallelAnts.size());
+    for (int i = 0; i < serialAnts.size(); i++)
+    {
+        EXPECT_EQ(serialAnts[i].get_location(), parallelAnts[i].get_location());
+        EXPECT_EQ(serialAnts[i].get_orientation(), parallelAnts[i].get_orientation());
+        EXPECT_EQ(serialAnts[i].has_food(), parallelAnts[i].has_food());
+    }
+}
+
+TEST(ParallelDeposition, GivenTwoWorldsWithTheSameSeed_AfterUpdatingWithOneAndFourThreads_ExpectIdenticalPheromones)
+{
+    World serialWorld{400,300};
+    World parallelWorld{400,300};
+    serialWorld.set_random_seed(5);
+    parallelWorld.set_random_seed(5);
+    parallelWorld.set_thread_count(4);
+    for (World* world : {&serialWorld, &parallelWorld})
+    {
+        world->add_food(120,100,100);
+        world->add_colony(200,150);
+    }
+
+    for (int tick = 0; tick < 40; tick++)
+    {
+        serialWorld.update();
+        parallelWorld.update();
+    }
+
+    EXPECT_EQ(serialWorld.get_pheromones().get_home_pheromones(), parallelWorld.get_pheromones().get_home_pheromones());
+    EXPECT_EQ(serialWorld.get_pheromones().get_food_pheromones(), parallelWorld.get_pheromones().get_food_pheromones());
+}
+
+TEST(StateHash, GivenWorldsWithTheSameSeedAndDifferentThreadCounts_AfterEveryTick_ExpectIdenticalStateHashes)
+{
+    std::vector<int> threadCounts{1, 2, 3, 8, 64};
+    std::vector<World> worlds;
+    for (int i = 0; i < threadCounts.size(); i++)
+    {
+        worlds.push_back(World{300,200});
+    }
+    for (int i = 0; i < worlds.size(); i++)
+    {
+        worlds[i].set_random_seed(17);
+        worlds[i].set_thread_count(threadCounts[i]);
+        worlds[i].set_lazy_pheromone_decay(true);
+        worlds[i].set_pheromone_sensing(summedAreaSensing);
+        worlds[i].set_obstacle_distance_field(true);
+        worlds[i].add_obstacle_line(60,40,200,120,4);
+        worlds[i].add_food(80,150,40);
+        worlds[i].add_food(240,50,40);
+        worlds[i].add_colony(150,100);
+    }
+
+    for (int tick = 0; tick < 60; tick++)
+    {
+        for (int i = 0; i < worlds.size(); i++)
+        {
+            if (tick == 30)
+            {
+                worlds[i].erase_line(100,60,180,110,8);
+            }
+            worlds[i].update();
+        }
+        for (int i = 1; i < worlds.size(); i++)
+        {
+            ASSERT_EQ(worlds[i].get_state_hash(), worlds[0].get_state_hash()) << "tick " << tick << ", " << threadCounts[i] << " threads";
+        }
+    }
+}
+
+TEST(StateHash, GivenAWorld_AfterChangingAnyPartOfTheState_ExpectADifferentStateHash)
+{
+    World testWorld{300,200};
+    testWorld.set_random_seed(3);
+    testWorld.add_colony(150,100);
+    testWorld.update();
+    std::vector<std::uint64_t> hashes{testWorld.get_state_hash()};
+
+    testWorld.add_food(50,50,10);
+    hashes.push_back(testWorld.get_state_hash());
+    testWorld.add_obstacle(250,150,3);
+    hashes.push_back(testWorld.get_state_hash());
+    testWorld.add_ant(Vector3D(20,20,0),1);
+    hashes.push_back(testWorld.get_state_hash());
+    testWorld.update();
+    hashes.push_back(testWorld.get_state_hash());
+
+    for (int i = 0; i < hashes.size(); i++)
+    {
+        for (int j = i + 1; j < hashes.size(); j++)
+        {
+            EXPECT_NE(hashes[i], hashes[j]);
+        }
+    }
+}
+
+TEST(StateHash, GivenTwoWorldsWithTheSameSeed_AfterRunningEachPhaseInsteadOfUpdate_ExpectIdenticalStateHashes)
+{
+    World updatedWorld{300,200};
+    World phasedWorld{300,200};
+    updatedWorld.set_random_seed(5);
+    phasedWorld.set_random_seed(5);
+    updatedWorld.add_colony(150,100,200);
+    phasedWorld.add_colony(150,100,200);
+    updatedWorld.add_food(170,110,30);
+    phasedWorld.add_food(170,110,30);
+
+    for (int tick = 0; tick < 40; tick++)
+    {
+        updatedWorld.update();
+        for (int phase = 0; phase < updatePhaseCount; phase++)
+        {
+            phasedWorld.run_phase(UpdatePhase(phase));
+        }
+    }
+    EXPECT_EQ(phasedWorld.get_ant_count(), 200);
+    EXPECT_EQ(updatedWorld.get_state_hash(), phasedWorld.get_state_hash());
+}
+
+TEST(WorldViews, GivenARunningWorld_AfterTakingViews_ExpectTheyMatchTheCopiesWithoutCopying)
+{
+    World world{300,200};
+    world.set_random_seed(9);
+    world.set_lazy_pheromone_decay(true);
+    world.add_obstacle(60,60,10);
+    world.add_colony(150,100,100);
+    world.add_food(170,110,30);
+    world.add_food(40,150,20);
+    for (int tick = 0; tick < 30; tick++)
+    {
+        world.update();
+    }
+
+    const AntPopulation& ants = world.view_ants();
+    std::vector<Ant> antCopies = world.get_ants();
+    ASSERT_EQ(ants.size(), antCopies.size());
+    for (int i = 0; i < ants.size(); i++)
+    {
+        EXPECT_EQ(ants.get_location(i)[0], antCopies[i].get_location()[0]);
+        EXPECT_EQ(ants.get_orientation(i), antCopies[i].get_orientation());
+        EXPECT_EQ(ants.has_food(i), antCopies[i].has_food());
+    }
+
+    ConstSpan<Food> food = world.view_food();
+    std::vector<Food> foodCopies = world.get_food_vector();
+    ASSERT_EQ(food.size(), foodCopies.size());
+    for (int i = 0; i < food.size(); i++)
+    {
+        EXPECT_EQ(food[i].get_quantity(), foodCopies[i].get_quantity());
+    }
+
+    const PheromoneGrid& pheromones = world.view_pheromones();
+    PheromoneGrid pheromoneCopy = world.get_pheromones();
+    EXPECT_EQ(&pheromones, &world.view_pheromones());
+    for (int i = 0; i < pheromones.get_cell_count(); i++)
+    {
+        EXPECT_EQ(pheromones.get_home_pheromone_at(i), pheromoneCopy.get_home_pheromone_at(i));
+        EXPECT_EQ(pheromones.get_food_pheromone_at(i), pheromoneCopy.get_food_pheromone_at(i));
+    }
+    EXPECT_EQ(pheromones.view_food_pheromones().data(), world.view_pheromones().view_food_pheromones().data());
+    EXPECT_EQ(pheromones.view_home_pheromones().size(), pheromones.get_cell_count());
+
+    EXPECT_EQ(world.view_obstacles().get_obstacle_words(), world.get_obstacles().get_obstacle_words());
+    EXPECT_EQ(world.view_colony().get_location()[0], 150);
+}
+
+TEST(RenderSnapshot, GivenARunningWorld_AfterCapturingEachTick_ExpectPixelsAndEntitiesToMatchTheWorld)
+{
+    std::vector<bool> lazyDecayModes{false, true};
+    for (int mode = 0; mode < lazyDecayModes.size(); mode++)
+    {
+        World world{300,200};
+        world.set_random_seed(4);
+        world.set_lazy_pheromone_decay(lazyDecayModes[mode]);
+        world.add_obstacle(60,60,10);
+        world.add_colony(150,100,100);
+        world.add_food(170,110,30);
+        RenderSnapshot snapshot;
+        long long editRevision{0};
+
+        for (int tick = 0; tick < 60; tick++)
+        {
+            world.update();
+            snapshot.capture(world, tick + 1, editRevision);
+            if (tick == 30)
+            {
+                world.clear_all();
+                world.add_colony(100,120,100);
+                editRevision++;
+            }
+        }
+
+        const PheromoneGrid& pheromones = world.view_pheromones();
+        ASSERT_EQ(snapshot.pheromoneImage.size(), pheromones.get_cell_count());
+        for (int i = 0; i < pheromones.get_cell_count(); i++)
+        {
+            EXPECT_EQ(snapshot.pheromoneImage[i], RenderSnapshot::compose_pheromone_pixel(pheromones.get_home_pheromone_at(i), pheromones.get_food_pheromone_at(i)));
+        }
+        EXPECT_EQ(snapshot.ticks, 60);
+        EXPECT_EQ(snapshot.ants.size(), world.get_ant_count());
+        EXPECT_EQ(snapshot.food.size(), world.get_food_vector().size());
+        EXPECT_EQ(snapshot.hasColony, world.has_colony());
+        EXPECT_EQ(snapshot.obstacleWords, world.view_obstacles().get_obstacle_words());
+    }
+}
+
+TEST(RenderSnapshot, GivenAnyPheromoneValues_AfterComposingAPixel_ExpectHomeBlendedOverFoodAtTheScaledAlphas)
+{
+    std::vector<int> values;
+    for (int value = -5; value <= 255*RenderSnapshot::pheromoneAlphaScale + 40; value++)
+    {
+        values.push_back(value);
+    }
+    values.push_back(1000000000);
+
+    for (int i = 0; i < values.size(); i++)
+    {
+        int alpha = std::max(std::min(values[i]/RenderSnapshot::pheromoneAlphaScale, 255), 0);
+        ASSERT_EQ(RenderSnapshot::compose_pheromone_pixel(values[i], 0), std::uint32_t(alpha) << 24 | alpha);
+        ASSERT_EQ(RenderSnapshot::compose_pheromone_pixel(0, values[i]), std::uint32_t(alpha) << 24 | alpha << 16);
+    }
+    for (int homeAlpha = 0; homeAlpha <= 255; homeAlpha += 5)
+    {
+        for (int foodAlpha = 0; foodAlpha <= 255; foodAlpha += 5)
+        {
+            int foodShown = int(std::lround(foodAlpha*(255 - homeAlpha)/255.0));
+            std::uint32_t pixel = RenderSnapshot::compose_pheromone_pixel(homeAlpha*RenderSnapshot::pheromoneAlphaScale, foodAlpha*RenderSnapshot::pheromoneAlphaScale);
+            EXPECT_EQ(pixel, std::uint32_t(homeAlpha + foodShown) << 24 | foodShown << 16 | homeAlpha);
+        }
+    }
+}
+
+TEST(SnapshotBuffer, GivenAWriterThread_AfterPublishingSnapshots_ExpectTheReaderToOnlySeeWholeSnapshotsInOrder)
+{
+    SnapshotBuffer buffer;
+    EXPECT_FALSE(buffer.has_new_snapshot());
+
+    const int publishCount = 2000;
+    std::thread writer([&buffer]()
+    {
+        for (int i = 1; i <= publishCount; i++)
+        {
+            RenderSnapshot& snapshot = buffer.get_back();
+            snapshot.ticks = i;
+            snapshot.width = i;
+            snapshot.food.assign(i % 7, Food(i, i, i));
+            buffer.publish();
+        }
+    });
+
+    long long lastTicks{0};
+    while (lastTicks < publishCount)
+    {
+        const RenderSnapshot& snapshot = buffer.acquire();
+        ASSERT_GE(snapshot.ticks, lastTicks);
+        ASSERT_EQ(snapshot.width, snapshot.ticks);
+        ASSERT_EQ(snapshot.food.size(), snapshot.ticks % 7);
+        for (int i = 0; i < snapshot.food.size(); i++)
+        {
+            ASSERT_EQ(snapshot.food[i].get_quantity(), snapshot.ticks);
+        }
+        lastTicks = snapshot.ticks;
+    }
+    writer.join();
+    EXPECT_FALSE(buffer.has_new_snapshot());
+    EXPECT_EQ(buffer.acquire().ticks, publishCount);
+}
+
+TEST(WorldCommandQueue, GivenCommandsPostedFromAnotherThread_AfterRunningThem_ExpectEachToRunOnceInOrder)
+{
+    World world{300,200};
+    WorldCommandQueue commands;
+    std::thread poster([&commands]()
+    {
+        for (int i = 0; i < 50; i++)
+        {
+            commands.post([i](World& target) { target.add_food(10 + i, 20, i + 1); });
+        }
+    });
+    poster.join();
+
+    EXPECT_EQ(commands.run_pending(world), 50);
+    EXPECT_EQ(commands.run_pending(world), 0);
+    std::vector<Food> food = world.get_food_vector();
+    ASSERT_EQ(food.size(), 50);
+    for (int i = 0; i < food.size(); i++)
+    {
+        EXPECT_EQ(food[i].get_quantity(), i + 1);
+    }
+}
+
+TEST(SimulationClock, GivenATargetRate_AfterTimePasses_ExpectTicksAtThatRateWithBoundedCatchUp)
+{
+    typedef SimulationClock::Clock Clock;
+    SimulationClock clock;
+    clock.set_target_ticks_per_second(100);
+    Clock::time_point start = Clock::now();
+
+    EXPECT_EQ(clock.ticks_due(start), 1);
+    EXPECT_EQ(clock.ticks_due(start + std::chrono::milliseconds(5)), 0);
+    EXPECT_EQ(clock.ticks_due(start + std::chrono::milliseconds(10)), 1);
+    EXPECT_EQ(clock.ticks_due(start + std::chrono::milliseconds(35)), 2);
+    EXPECT_EQ(clock.get_wake_time(start + std::chrono::milliseconds(35)), start + std::chrono::milliseconds(40));
+
+    EXPECT_EQ(clock.ticks_due(start + std::chrono::seconds(5)), SimulationClock::maxCatchUpTicks);
+    EXPECT_EQ(clock.ticks_due(start + std::chrono::seconds(5)), 0);
+    EXPECT_EQ(clock.ticks_due(start + std::chrono::milliseconds(5010)), 1);
+
+    clock.set_target_ticks_per_second(0);
+    Clock::time_point paused = start + std::chrono::seconds(6);
+    EXPECT_EQ(clock.ticks_due(paused), 0);
+    EXPECT_EQ(clock.get_wake_time(paused), paused + SimulationClock::idlePollInterval);
+}
+
+TEST(SimulationClock, GivenTurboOrAFastForward_AfterRunningThem_ExpectBackToBackTicksWithThrottledPublishing)
+{
+    typedef SimulationClock::Clock Clock;
+    SimulationClock clock;
+    clock.set_target_ticks_per_second(0);
+    Clock::time_point start = Clock::now();
+    EXPECT_TRUE(clock.should_publish(start));
+
+    clock.fast_forward(1000);
+    int ticksRun{0};
+    int published{0};
+    for (int i = 0; i < 2000; i++)
+    {
+        int dueTicks = clock.ticks_due(start);
+        ticksRun += dueTicks;
+        published += dueTicks > 0 && clock.should_publish(start);
+    }
+    EXPECT_EQ(ticksRun, 1000);
+    EXPECT_EQ(published, 1);
+    EXPECT_EQ(clock.get_fast_forward_remaining(), 0);
+
+    clock.set_turbo(true);
+    EXPECT_EQ(clock.ticks_due(start), 1);
+    EXPECT_FALSE(clock.should_publish(start + SimulationClock::publishInterval));
+    EXPECT_TRUE(clock.should_publish(start + SimulationClock::turboPublishInterval));
+
+    clock.set_turbo(false);
+    clock.set_target_ticks_per_second(50);
+    Clock::time_point resumed = start + std::chrono::seconds(10);
+    EXPECT_EQ(clock.ticks_due(resumed), 1);
+    EXPECT_EQ(clock.ticks_due(resumed + std::chrono::milliseconds(10)), 0);
+    EXPECT_EQ(clock.ticks_due(resumed + std::chrono::milliseconds(20)), 1);
+}
+
+TEST(FusedUpdate, GivenPhasedAndFusedWorldsWithTheSameSeed_AfterEveryTick_ExpectIdenticalStateHashes)
+{
+    std::vector<int> threadCounts{1, 1, 3, 8};
+    std::vector<World> worlds;
+    for (int i = 0; i < threadCounts.size(); i++)
+    {
+        worlds.push_back(World{300,200});
+    }
+    for (int i = 0; i < worlds.size(); i++)
+    {
+        worlds[i].set_random_seed(23);
+        worlds[i].set_thread_count(threadCounts[i]);
+        worlds[i].set_update_mode(i == 0 ? phasedUpdate : fusedUpdate);
+        worlds[i].set_lazy_pheromone_decay(true);
+        worlds[i].set_pheromone_sensing(summedAreaSensing);
+        worlds[i].set_obstacle_distance_field(true);
+        worlds[i].add_obstacle_line(60,40,120,160,4);
+        worlds[i].add_colony(150,100,500);
+        worlds[i].add_food(158,100,30);
+        worlds[i].add_food(140,95,5);
+        worlds[i].add_food(250,60,40);
+    }
+
+    for (int tick = 0; tick < 80; tick++)
+    {
+        for (int i = 0; i < worlds.size(); i++)
+        {
+            if (tick == 40)
+            {
+                worlds[i].erase_line(130,80,170,120,6);
+            }
+            worlds[i].update();
+        }
+        for (int i = 1; i < worlds.size(); i++)
+        {
+            ASSERT_EQ(worlds[0].get_state_hash(), worlds[i].get_state_hash()) << "tick " << tick << ", world " << i;
+        }
+    }
+    EXPECT_LT(worlds[0].get_food_vector().size(), 3);
+}
+
+TEST(FusedUpdate, GivenAFusedWorldWhoseAntsDropBelowOneChunkPerWorker_AfterUpdating_ExpectNoStalePickupCandidates)
+{
+    World phasedWorld{500,500};
+    World fusedWorld{500,500};
+    fusedWorld.set_thread_count(4);
+    fusedWorld.set_update_mode(fusedUpdate);
+    World* worlds[] = {&phasedWorld, &fusedWorld};
+    for (int i = 0; i < 2; i++)
+    {
+        worlds[i]->set_random_seed(31);
+        worlds[i]->add_colony(250,250,300);
+        worlds[i]->add_food(250,250,1000);
+        worlds[i]->update();
+        worlds[i]->erase_ants(250,250,100);
+        worlds[i]->add_ant(Vector3D(250,250,0), 1.0);
+        worlds[i]->add_ant(Vector3D(252,250,0), 2.0);
+    }
+
+    for (int tick = 0; tick < 10; tick++)
+    {
+        phasedWorld.update();
+        fusedWorld.update();
+        ASSERT_EQ(phasedWorld.get_state_hash(), fusedWorld.get_state_hash()) << "tick " << tick;
+    }
+    EXPECT_EQ(fusedWorld.get_ant_count(), 2);
+}
+
+#ifdef ANTSIM_STATS
+TEST(SimulationStats, GivenAWorldWithAntsAwayFromTheEdges_AfterUpdating_ExpectEveryCellOfBothSensorsSampledAndTimedPhases)
+{
+    World testWorld{300,200};
+    testWorld.set_random_seed(4);
+    testWorld.add_colony(150,100,200);
+    testWorld.add_obstacle_line(100,20,100,180,3);
+    for (int i = 0; i < 10; i++)
+    {
+        testWorld.update();
+    }
+
+    SimulationStats stats = testWorld.stats();
+    EXPECT_EQ(stats.ticks, 10);
+    EXPECT_EQ(stats.averagedTicks, 10);
+    // Each exact sensor reads smellRange x smellRange cells.
+    int cellsPerTick = 200*2*Ant::get_smell_range()*Ant::get_smell_range();
+    EXPECT_EQ(stats.lastCounters[pheromoneSamplesCounter], cellsPerTick);
+    EXPECT_EQ(stats.totalCounters[pheromoneSamplesCounter], 10*cellsPerTick);
+    EXPECT_DOUBLE_EQ(stats.averageCounters[pheromoneSamplesCounter], cellsPerTick);
+    EXPECT_GT(stats.totalCounters[rayCellTestsCounter], 0);
+    double totalMilliseconds{0};
+    for (int phase = 0; phase < updatePhaseCount; phase++)
+    {
+        EXPECT_GE(stats.lastPhaseMilliseconds[phase], 0);
+        totalMilliseconds += stats.averagePhaseMilliseconds[phase];
+    }
+    EXPECT_GT(totalMilliseconds, 0);
+
+    testWorld.clear_stats();
+    EXPECT_EQ(testWorld.stats().ticks, 0);
+    EXPECT_EQ(testWorld.stats().totalCounters[pheromoneSamplesCounter], 0);
+}
+
+TEST(SimulationStats, GivenSensorsAtAnEdgeAndOnSummedAreaTables_WhenSensing_ExpectOnlyTheValuesReadCounted)
+{
+    PheromoneGrid testGrid{100,100,1};
+    Vector3D interior(50,50,0);
+    Vector3D corner(1,1,0);
+
+    std::fill(threadStatCounters, threadStatCounters + statCounterCount, 0);
+    testGrid.average_home_pheromones_right(interior, 0, 12);
+    EXPECT_EQ(threadStatCounters[pheromoneSamplesCounter], 144);
+
+    std::fill(threadStatCounters, threadStatCounters + statCounterCount, 0);
+    testGrid.average_home_pheromones_right(corner, M_PI, 12);
+    EXPECT_LT(threadStatCounters[pheromoneSamplesCounter], 144);
+
+    testGrid.set_sensing_mode(summedAreaSensing);
+    testGrid.build_summed_area_tables();
+    std::fill(threadStatCounters, threadStatCounters + statCounterCount, 0);
+    testGrid.average_home_pheromones_right(interior, 0, 12);
+    EXPECT_EQ(threadStatCounters[pheromoneSamplesCounter], testGrid.get_summed_area_blocks()*testGrid.get_summed_area_blocks());
+    std::fill(threadStatCounters, threadStatCounters + statCounterCount, 0);
+}
+
+TEST(SimulationStats, GivenWorldsWithDifferentThreadCounts_AfterForaging_ExpectTheSameCountersAndPickupsMatchingFoodTaken)
+{
+    World singleWorld{300,200};
+    World threadedWorld{300,200};
+    threadedWorld.set_thread_count(4);
+    for (World* world : {&singleWorld, &threadedWorld})
+    {
+        world->set_random_seed(8);
+        world->add_colony(150,100);
+        world->add_food(160,100,1000);
+        for (int i = 0; i < 100; i++)
+        {
+            world->update();
+        }
+    }
+
+    SimulationStats singleStats = singleWorld.stats();
+    SimulationStats threadedStats = threadedWorld.stats();
+    EXPECT_EQ(singleStats.averagedTicks, StatsRecorder::statsWindow);
+    for (int counter = 0; counter < statCounterCount; counter++)
+    {
+        EXPECT_EQ(singleStats.totalCounters[counter], threadedStats.totalCounters[counter]);
+    }
+    int remaining = singleWorld.get_food_vector().empty() ? 0 : singleWorld.get_food_vector()[0].get_quantity();
+    EXPECT_GT(singleStats.totalCounters[foodPickupsCounter], 0);
+    EXPECT_EQ(singleStats.totalCounters[foodPickupsCounter], 1000 - remaining);
+    EXPECT_LE(singleStats.totalCounters[foodDropsCounter], singleStats.totalCounters[foodPickupsCounter]);
+}
+#endif
+
+TEST(LazyPheromoneDecay, GivenTwoWorldsWithTheSameSeed_AfterUpdatingWithEagerAndLazyDecay_ExpectIdenticalPheromones)
+{
+    World eagerWorld{400,300};
+    World lazyWorld{400,300};
+    eagerWorld.set_random_seed(9);
+    lazyWorld.set_random_seed(9);
+    lazyWorld.set_lazy_pheromone_decay(true);
+    lazyWorld.set_thread_count(3);
+    for (World* world : {&eagerWorld, &lazyWorld})
+    {
+        world->add_food(120,100,100);
+        world->add_colony(200,150);
+    }
+
+    for (int tick = 0; tick < 60; tick++)
+    {
+        eagerWorld.update();
+        lazyWorld.update();
+    }
+
+    EXPECT_EQ(eagerWorld.get_pheromones().get_home_pheromones(), lazyWorld.get_pheromones().get_home_pheromones());
+    EXPECT_EQ(eagerWorld.get_pheromones().get_food_pheromones(), lazyWorld.get_pheromones().get_food_pheromones());
+}
+
+TEST(SummedAreaSensing, GivenTwoWorldsWithTheSameSeed_AfterUpdatingWithOneAndThreeThreads_ExpectIdenticalAnts)
+{
+    World serialWorld{400,300};
+    World parallelWorld{400,300};
+    serialWorld.set_random_seed(4);
+    parallelWorld.set_random_seed(4);
+    parallelWorld.set_thread_count(3);
+    for (World* world : {&serialWorld, &parallelWorld})
+    {
+        world->set_pheromone_sensing(summedAreaSensing);
+        world->add_food(120,100,100);
+        world->add_colony(200,150);
+    }
+
+    for (int tick = 0; tick < 60; tick++)
+    {
+        serialWorld.update();
+        parallelWorld.update();
+    }
+
+    std::vector<Ant> serialAnts = serialWorld.get_ants();
+    std::vector<Ant> parallelAnts = parallelWorld.get_ants();
+    ASSERT_EQ(serialAnts.size(), parallelAnts.size());
+    for (int i = 0; i < serialAnts.size(); i++)
+    {
+        EXPECT_EQ(serialAnts[i].get_orientation(), parallelAnts[i].get_orientation());
+    }
+}
+
+TEST(ObstacleDistanceField, GivenTwoWorldsWithTheSameSeed_AfterUpdatingWithAndWithoutTheDistanceField_ExpectIdenticalAnts)
+{
+    World marchingWorld{400,300};
+    World tracingWorld{400,300};
+    marchingWorld.set_random_seed(6);
+    tracingWorld.set_random_seed(6);
+    tracingWorld.set_obstacle_distance_field(true);
+    tracingWorld.set_thread_count(2);
+    for (World* world : {&marchingWorld, &tracingWorld})
+    {
+        world->add_obstacle_line(100,50,300,250,6);
+        world->add_food(120,100,100);
+        world->add_colony(200,150);
+    }
+
+    for (int tick = 0; tick < 80; tick++)
+    {
+        marchingWorld.update();
+        tracingWorld.update();
+    }
+
+    std::vector<Ant> marchingAnts = marchingWorld.get_ants();
+    std::vector<Ant> tracingAnts = tracingWorld.get_ants();
+    ASSERT_EQ(marchingAnts.size(), tracingAnts.size());
+    for (int i = 0; i < marchingAnts.size(); i++)
+    {
+        EXPECT_EQ(marchingAnts[i].get_location()[0], tracingAnts[i].get_location()[0]);
+        EXPECT_EQ(marchingAnts[i].get_orientation(), tracingAnts[i].get_orientation());
+    }
+}
+
 //########################################################
 // Food Tests
 //########################################################
@@ -707,21 +1448,237 @@ TEST(ReduceFoodQuantity, AfterReducingTheQuantityOfAFoodWithQuantityOne_WhenGett
     Food testFood{88,2,1};
     int goldQuantity = 0;
 
-    testFood.reduce_quantity(1);
-    int testFoodQuantity = testFood.get_quantity();
+    testFood.reduce_quantity(1);
+    int testFoodQuantity = testFood.get_quantity();
+
+    EXPECT_EQ(testFoodQuantity, goldQuantity);
+}
+
+TEST(ReduceFoodQuantity, AfterReducingTheQuantityOfFoodByTwo_WhenGettingFoodQuantity_ExpectProperQuantity)
+{
+    Food testFood{88,2,5};
+    int goldQuantity = 3;
+
+    testFood.reduce_quantity(2);
+    int testFoodQuantity = testFood.get_quantity();
+
+    EXPECT_EQ(testFoodQuantity, goldQuantity);
+}
+
+TEST(FoodIndex, GivenRandomPilesAndRemovals_WhenFindingTheNearestPile_ExpectTheSameAsScanningEveryPile)
+{
+    FoodIndex testIndex{400,300,30};
+    std::mt19937 generator(8);
+    std::uniform_int_distribution<int> xValues(0, 400);
+    std::uniform_int_distribution<int> yValues(0, 300);
+    for (int i = 0; i < 500; i++)
+    {
+        testIndex.add(Food(xValues(generator), yValues(generator), 3));
+    }
+    for (int i = 0; i < 100; i++)
+    {
+        testIndex.remove(std::uniform_int_distribution<int>(0, testIndex.size() - 1)(generator));
+    }
+    testIndex.remove_within(200, 150, 40);
+    ASSERT_EQ(testIndex.size(), testIndex.get_foods().size());
+
+    for (int i = 0; i < 1000; i++)
+    {
+        double x = xValues(generator);
+        double y = yValues(generator);
+        int goldNearest{-1};
+        double goldDistance{0};
+        for (int j = 0; j < testIndex.size(); j++)
+        {
+            Vector3D location = testIndex.get_food(j).get_location();
+            double dx = location[0] - x;
+            double dy = location[1] - y;
+            if (std::abs(dx) < 30 && std::abs(dy) < 30 && (goldNearest < 0 || dx*dx + dy*dy < goldDistance))
+            {
+                goldNearest = j;
+                goldDistance = dx*dx + dy*dy;
+            }
+            EXPECT_FALSE((dx + x - 200)*(dx + x - 200) + (dy + y - 150)*(dy + y - 150) < 40*40);
+        }
+        EXPECT_EQ(testIndex.find_nearest(x, y, 30), goldNearest);
+    }
+}
+
+TEST(LookingForFood, GivenTwoPilesInSight_AfterLookingForFood_ExpectTurnedTowardTheNearerPile)
+{
+    std::vector<Food> foodVector;
+    foodVector.push_back(Food(100,105,25));
+    foodVector.push_back(Food(100,80,25));
+    Ant testAnt{Vector3D(100,100,0), 0};
+
+    testAnt.look_for_food(foodVector);
+
+    EXPECT_NEAR(testAnt.get_orientation(), M_PI/2, 0.1);
+}
+
+TEST(Erasing, GivenAdjacentFoodPiles_AfterErasingOverThem_ExpectEveryPileRemoved)
+{
+    World testWorld{500,500};
+    for (int i = 0; i < 6; i++)
+    {
+        testWorld.add_food(100 + i,100,10);
+    }
+    testWorld.add_food(300,300,10);
+
+    testWorld.erase(102,100,10);
+
+    ASSERT_EQ(testWorld.get_food_vector().size(), 1);
+    EXPECT_EQ(testWorld.get_food_vector()[0].get_location()[0], 300);
+}
+
+//######################################################
+//WorkerPool Tests
+//######################################################
+
+TEST(WorkerPoolParallelFor, GivenAPoolWithThreeThreads_AfterRunningParallelFor_ExpectEveryIndexVisitedOnce)
+{
+    WorkerPool testPool{3};
+    std::vector<int> visits(1000, 0);
+
+    testPool.parallel_for(visits.size(), [&visits](int begin, int end, int)
+    {
+        for (int i = begin; i < end; i++)
+        {
+            visits[i]++;
+        }
+    });
+
+    for (int i = 0; i < visits.size(); i++)
+    {
+        EXPECT_EQ(visits[i], 1);
+    }
+}
+
+TEST(WorkerPoolParallelFor, GivenAnAlignment_WhenSplittingARange_ExpectChunksStartOnAlignedIndices)
+{
+    WorkerPool testPool{4};
+    int begin;
+    int end;
+    int previousEnd{0};
+
+    for (int worker = 0; worker < 4; worker++)
+    {
+        testPool.get_chunk(1000, 64, worker, begin, end);
+
+        EXPECT_EQ(begin % 64, 0);
+        EXPECT_EQ(begin, previousEnd);
+        previousEnd = end;
+    }
+    EXPECT_EQ(previousEnd, 1000);
+}
+
+//######################################################
+//RandomStreams Tests
+//######################################################
+
+TEST(PcgStream, GivenTheReferenceSeedAndStream_WhenDrawingBits_ExpectTheReferenceSequence)
+{
+    PcgStream testStream{42, 54};
+    std::vector<std::uint32_t> goldBits{0xa15c02b7, 0x7b47f409, 0xba1d3330, 0x83d2f293, 0xbfa4784b, 0xcbed606e};
+
+    for (int i = 0; i < goldBits.size(); i++)
+    {
+        EXPECT_EQ(testStream.next_bits(), goldBits[i]);
+    }
+}
+
+TEST(RandomStreams, GivenASeed_WhenFillingARangeInPieces_ExpectTheSameValuesAsSingleLookups)
+{
+    RandomStreams testStreams{99};
+    std::vector<double> values(1000);
+
+    testStreams.fill_unit(3, 500, values.data(), 300);
+    testStreams.fill_unit(3, 800, values.data() + 300, 700);
+
+    double sum{0};
+    for (int i = 0; i < values.size(); i++)
+    {
+        EXPECT_EQ(values[i], testStreams.get_unit(3, 500 + i));
+        EXPECT_GE(values[i], 0);
+        EXPECT_LT(values[i], 1);
+        sum += values[i];
+    }
+    EXPECT_NEAR(sum/values.size(), 0.5, 0.05);
+}
+
+TEST(RandomStreams, GivenDifferentSeedsOrStreams_WhenDrawingValues_ExpectDifferentSequences)
+{
+    RandomStreams testStreams{1};
+    RandomStreams sameStreams{1};
+    RandomStreams otherStreams{2};
+
+    int sameSeedMatches{0};
+    int otherSeedMatches{0};
+    int otherStreamMatches{0};
+    for (int i = 0; i < 100; i++)
+    {
+        sameSeedMatches += testStreams.get_bits(0, i) == sameStreams.get_bits(0, i);
+        otherSeedMatches += testStreams.get_bits(0, i) == otherStreams.get_bits(0, i);
+        otherStreamMatches += testStreams.get_bits(0, i) == testStreams.get_bits(1, i);
+    }
+
+    EXPECT_EQ(sameSeedMatches, 100);
+    EXPECT_EQ(otherSeedMatches, 0);
+    EXPECT_EQ(otherStreamMatches, 0);
+}
+
+//######################################################
+//FastMath Tests
+//######################################################
+
+TEST(FastTrigonometry, GivenAnglesAcrossManyTurns_WhenComputingFastSineAndCosine_ExpectWithinDocumentedErrorOfLibm)
+{
+    for (double angle = -100; angle < 100; angle += 0.001)
+    {
+        double sine, cosine;
+        fast_sin_cos(angle, sine, cosine);
+        EXPECT_NEAR(sine, sin(angle), 2.7e-9);
+        EXPECT_NEAR(cosine, cos(angle), 2.7e-9);
+    }
+}
 
-    EXPECT_EQ(testFoodQuantity, goldQuantity);
+TEST(FastTrigonometry, GivenPointsAroundTheOrigin_WhenComputingFastAtan2_ExpectWithinDocumentedErrorOfLibm)
+{
+    for (double y = -50; y <= 50; y += 0.7)
+    {
+        for (double x = -50; x <= 50; x += 0.9)
+        {
+            EXPECT_NEAR(fast_atan2(y, x), atan2(y, x), 8.1e-9);
+        }
+    }
+    EXPECT_NEAR(fast_atan(1e12), atan(1e12), 8.1e-9);
+    EXPECT_NEAR(fast_atan(-3), atan(-3), 8.1e-9);
 }
 
-TEST(ReduceFoodQuantity, AfterReducingTheQuantityOfFoodByTwo_WhenGettingFoodQuantity_ExpectProperQuantity)
+TEST(FastTrigonometry, GivenALibmAndAFastTrigWorldWithTheSameSeed_AfterOneUpdate_ExpectNearlyIdenticalAnts)
 {
-    Food testFood{88,2,5};
-    int goldQuantity = 3;
+    World libmWorld{200,200,libmTrig};
+    World fastWorld{200,200,fastTrig};
+    libmWorld.set_random_seed(2);
+    fastWorld.set_random_seed(2);
+    libmWorld.add_colony(100,100);
+    fastWorld.add_colony(100,100);
 
-    testFood.reduce_quantity(2);
-    int testFoodQuantity = testFood.get_quantity();
+    libmWorld.update();
+    fastWorld.update();
 
-    EXPECT_EQ(testFoodQuantity, goldQuantity);
+    EXPECT_EQ(fastWorld.get_trig_mode(), fastTrig);
+    EXPECT_EQ(fastWorld.get_pheromones().get_trig_mode(), fastTrig);
+    EXPECT_EQ(fastWorld.get_obstacles().get_trig_mode(), fastTrig);
+    std::vector<Ant> libmAnts = libmWorld.get_ants();
+    std::vector<Ant> fastAnts = fastWorld.get_ants();
+    ASSERT_EQ(libmAnts.size(), fastAnts.size());
+    for (int i = 0; i < libmAnts.size(); i++)
+    {
+        EXPECT_NEAR(fastAnts[i].get_location()[0], libmAnts[i].get_location()[0], 1e-6);
+        EXPECT_NEAR(fastAnts[i].get_location()[1], libmAnts[i].get_location()[1], 1e-6);
+        EXPECT_NEAR(fastAnts[i].get_orientation(), libmAnts[i].get_orientation(), 1e-6);
+    }
 }
 
 //######################################################
@@ -985,6 +1942,317 @@ TEST(DecayAllPheromones, AfterDecayingPheromonesOnPheromoneGridWithHomePheromone
     EXPECT_EQ(pheromoneValue2, goldValue2);
 }
 
+class DecayKernelInputs:public testing::Test
+{
+public:
+    DecayKernelInputs()
+    {
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<int> smallValues(-5, 1000);
+        std::uniform_int_distribution<int> largeValues(0, 700000000);
+        for (int i = 0; i < 1003; i++)
+        {
+            homeValues.push_back(i % 3 == 0 ? largeValues(generator) : smallValues(generator));
+            foodValues.push_back(smallValues(generator));
+        }
+        for (int value = 195; value <= 205; value++)
+        {
+            homeValues[value] = value;
+            foodValues[value] = value - 194;
+        }
+    }
+
+protected:
+    std::vector<int> homeValues;
+    std::vector<int> foodValues;
+};
+
+TEST_F(DecayKernelInputs, GivenEachSupportedDecayKernel_AfterDecaying_ExpectSameValuesAsScalarDecayCellByCell)
+{
+    PheromoneGrid referenceGrid{10,10,1};
+    std::vector<int> goldHome = homeValues;
+    std::vector<int> goldFood = foodValues;
+    referenceGrid.decay_pheromone_vector(goldHome);
+    referenceGrid.decay_pheromone_vector(goldFood);
+
+    DecayKernel kernels[] = {scalarDecay, sse42Decay, avx2Decay, avx512Decay};
+    for (DecayKernel kernel : kernels)
+    {
+        if (!is_decay_kernel_supported(kernel))
+        {
+            continue;
+        }
+        std::vector<int> home = homeValues;
+        std::vector<int> food = foodValues;
+
+        decay_pheromones(kernel, home.data(), food.data(), home.size(), referenceGrid.get_pheromone_decay_value(), referenceGrid.get_exponential_decay_limit());
+
+        for (int i = 0; i < home.size(); i++)
+        {
+            EXPECT_EQ(home[i], goldHome[i]) << "kernel " << kernel << " cell " << i;
+            EXPECT_EQ(food[i], goldFood[i]) << "kernel " << kernel << " cell " << i;
+        }
+    }
+}
+
+TEST(LazyPheromoneDecay, GivenAnEagerAndALazyGrid_AfterTheSameDepositsAndDecays_ExpectIdenticalPheromones)
+{
+    PheromoneGrid eagerGrid{200,150,1};
+    PheromoneGrid lazyGrid{200,150,1};
+    lazyGrid.set_lazy_decay(true);
+    std::mt19937 generator(3);
+    std::uniform_int_distribution<int> xValues(5, 190);
+    std::uniform_int_distribution<int> yValues(5, 140);
+    std::uniform_int_distribution<int> strengths(0, 3000);
+
+    for (int tick = 0; tick < 400; tick++)
+    {
+        if (tick % 7 < 3)
+        {
+            int x = xValues(generator);
+            int y = yValues(generator);
+            int strength = strengths(generator);
+            eagerGrid.spread_home_pheromone(x,y,strength,3);
+            lazyGrid.spread_home_pheromone(x,y,strength,3);
+            eagerGrid.add_food_pheromone(y,x % 140,strength*40);
+            lazyGrid.add_food_pheromone(y,x % 140,strength*40);
+        }
+        eagerGrid.decay_all_pheromones();
+        lazyGrid.decay_all_pheromones();
+
+        if (tick % 50 == 0)
+        {
+            Vector3D location(xValues(generator), yValues(generator), 0);
+            EXPECT_EQ(lazyGrid.average_home_pheromones_left(location, 1, 12), eagerGrid.average_home_pheromones_left(location, 1, 12));
+            EXPECT_EQ(lazyGrid.average_food_pheromones_right(location, 1, 12), eagerGrid.average_food_pheromones_right(location, 1, 12));
+        }
+    }
+
+    EXPECT_EQ(lazyGrid.get_home_pheromones(), eagerGrid.get_home_pheromones());
+    EXPECT_EQ(lazyGrid.get_food_pheromones(), eagerGrid.get_food_pheromones());
+}
+
+TEST(LazyPheromoneDecay, GivenAStrongPheromone_WhenDecayingManyStepsAtOnce_ExpectSameValueAsDecayingOneStepAtATime)
+{
+    PheromoneGrid testGrid{10,10,1};
+    std::vector<int> goldValues{250000, 201, 200, 199, 7, 1, 0, -4};
+
+    for (int steps = 0; steps < 1200; steps += 37)
+    {
+        std::vector<int> values{250000, 201, 200, 199, 7, 1, 0, -4};
+        for (int i = 0; i < values.size(); i++)
+        {
+            EXPECT_EQ(testGrid.decay_pheromone_value(values[i], steps), goldValues[i]);
+        }
+        for (int step = 0; step < 37; step++)
+        {
+            testGrid.decay_pheromone_vector(goldValues);
+        }
+    }
+}
+
+TEST(ActivePheromoneTiles, GivenAFreshGrid_AfterDepositingPheromone_ExpectOnlyTheTouchedTileActive)
+{
+    PheromoneGrid testGrid{127,95,1};
+    EXPECT_EQ(testGrid.get_tile_count(), 12);
+    EXPECT_EQ(testGrid.get_active_tile_count(), 0);
+
+    testGrid.add_home_pheromone(40,70,100);
+
+    ASSERT_EQ(testGrid.get_active_tile_count(), 1);
+    EXPECT_EQ(testGrid.get_active_tiles()[0], testGrid.get_tile_index(testGrid.get_index(40,70)));
+    EXPECT_DOUBLE_EQ(testGrid.get_active_tile_occupancy(), 1.0/12);
+}
+
+TEST(ActivePheromoneTiles, GivenADepositAcrossATileBorder_AfterDecayingToZero_ExpectNoActiveTiles)
+{
+    PheromoneGrid testGrid{127,95,1};
+    testGrid.spread_food_pheromone(32,32,50,2);
+    EXPECT_EQ(testGrid.get_active_tile_count(), 4);
+
+    for (int tick = 0; tick < 100; tick++)
+    {
+        testGrid.decay_all_pheromones();
+    }
+
+    EXPECT_EQ(testGrid.get_active_tile_count(), 0);
+    EXPECT_EQ(testGrid.get_food_pheromones(), std::vector<int>(128*96, 0));
+}
+
+TEST(ActivePheromoneTiles, GivenALazyGrid_AfterDecayingToZero_ExpectTheTilesRetiredBySweeping)
+{
+    PheromoneGrid testGrid{127,95,1};
+    testGrid.set_lazy_decay(true);
+    testGrid.spread_home_pheromone(100,10,50,2);
+
+    for (int tick = 0; tick < 100; tick++)
+    {
+        testGrid.decay_all_pheromones();
+    }
+
+    EXPECT_EQ(testGrid.get_active_tile_count(), 0);
+    EXPECT_EQ(testGrid.get_home_pheromone(100,10), 0);
+}
+
+TEST(ActivePheromoneTiles, GivenActiveTiles_AfterClearingPheromones_ExpectNoActiveTiles)
+{
+    PheromoneGrid testGrid{127,95,1};
+    testGrid.add_home_pheromone(1,1,100);
+    testGrid.add_food_pheromone(120,90,100);
+
+    testGrid.clear();
+
+    EXPECT_EQ(testGrid.get_active_tile_count(), 0);
+    EXPECT_EQ(testGrid.get_home_pheromone(1,1), 0);
+    EXPECT_EQ(testGrid.get_food_pheromone(120,90), 0);
+}
+
+TEST(ActivePheromoneTiles, GivenALazyGridWithEdgeTiles_WhenExportingActiveTiles_ExpectTheDecayedCellsOfEachTile)
+{
+    PheromoneGrid testGrid{127,95,1};
+    testGrid.set_lazy_decay(true);
+    testGrid.spread_home_pheromone(100,10,5000,3);
+    testGrid.spread_home_pheromone(125,93,7000,2);
+    testGrid.decay_all_pheromones();
+    testGrid.decay_all_pheromones();
+
+    std::vector<int> tiles;
+    std::vector<int> values;
+    testGrid.export_active_tiles(homeChannel, tiles, values);
+
+    std::vector<int> cells = testGrid.get_home_pheromones();
+    int tileSize = testGrid.get_tile_size();
+    ASSERT_EQ(tiles, testGrid.get_active_tiles());
+    ASSERT_EQ(values.size(), tiles.size()*tileSize*tileSize);
+    long long exportedSum = 0;
+    for (int i = 0; i < tiles.size(); i++)
+    {
+        int firstColumn, firstRow, lastColumn, lastRow;
+        testGrid.get_tile_bounds(tiles[i], firstColumn, firstRow, lastColumn, lastRow);
+        for (int row = 0; row < tileSize; row++)
+        {
+            for (int column = 0; column < tileSize; column++)
+            {
+                int value = values[i*tileSize*tileSize + row*tileSize + column];
+                exportedSum += value;
+                if (firstRow + row < lastRow && firstColumn + column < lastColumn)
+                {
+                    EXPECT_EQ(value, cells[(firstRow + row)*testGrid.get_grid_width() + firstColumn + column]);
+                }
+                else
+                {
+                    EXPECT_EQ(value, 0);
+                }
+            }
+        }
+    }
+    long long cellSum = 0;
+    for (int i = 0; i < cells.size(); i++)
+    {
+        cellSum += cells[i];
+    }
+    EXPECT_EQ(exportedSum, cellSum);
+    EXPECT_GT(cellSum, 0);
+}
+
+TEST(ExactSensing, GivenALocationWhoseSensingAreaMissesTheGrid_WhenSensing_ExpectZero)
+{
+    PheromoneGrid testGrid{100,100,1};
+    testGrid.add_home_pheromone(50,50,100);
+    Vector3D location(5000,5000,0);
+
+    EXPECT_EQ(testGrid.average_home_pheromones_right(location, 0, 5), 0);
+    EXPECT_EQ(testGrid.average_home_pheromones_left(location, 0, 5), 0);
+}
+
+TEST(SummedAreaSensing, GivenALinearPheromoneField_WhenSensingWithSummedAreaTables_ExpectCloseToTheExactAverage)
+{
+    PheromoneGrid testGrid{100,100,1};
+    for (int x = 0; x <= 100; x++)
+    {
+        for (int y = 0; y <= 100; y++)
+        {
+            testGrid.add_home_pheromone(x,y,10*x + 3*y);
+        }
+    }
+
+    for (double orientation = 0; orientation < 6.28; orientation += 0.4)
+    {
+        Vector3D location(50,50,0);
+        testGrid.set_sensing_mode(exactSensing);
+        double exactRight = testGrid.average_home_pheromones_right(location, orientation, 12);
+        double exactLeft = testGrid.average_home_pheromones_left(location, orientation, 12);
+
+        testGrid.set_sensing_mode(summedAreaSensing);
+        testGrid.build_summed_area_tables();
+        EXPECT_NEAR(testGrid.average_home_pheromones_right(location, orientation, 12), exactRight, 10);
+        EXPECT_NEAR(testGrid.average_home_pheromones_left(location, orientation, 12), exactLeft, 10);
+    }
+}
+
+TEST(SummedAreaSensing, GivenStaleSummedAreaTables_WhenSensing_ExpectTheExactAverage)
+{
+    PheromoneGrid testGrid{100,100,1};
+    testGrid.set_sensing_mode(summedAreaSensing);
+    testGrid.build_summed_area_tables();
+    testGrid.spread_food_pheromone(55,45,300,3);
+    Vector3D location(50,50,0);
+
+    double staleRight = testGrid.average_food_pheromones_right(location, 0, 12);
+    testGrid.set_sensing_mode(exactSensing);
+
+    EXPECT_FALSE(testGrid.are_summed_area_tables_current());
+    EXPECT_EQ(staleRight, testGrid.average_food_pheromones_right(location, 0, 12));
+}
+
+TEST(StencilSensing, GivenAQuantizedHeadingAndAnIntegerLocation_WhenSensingWithStencils_ExpectTheExactAverageUpToFloatingPointRounding)
+{
+    PheromoneGrid testGrid{100,100,1};
+    std::mt19937 generator(5);
+    std::uniform_int_distribution<int> coordinates(5, 95);
+    for (int i = 0; i < 300; i++)
+    {
+        testGrid.spread_food_pheromone(coordinates(generator),coordinates(generator),200,3);
+    }
+    testGrid.build_sensing_stencils(12, 8);
+    std::uniform_int_distribution<int> interiorCoordinates(20, 80);
+
+    for (int heading = 0; heading < 8; heading++)
+    {
+        Vector3D location(interiorCoordinates(generator), interiorCoordinates(generator), 0);
+        double orientation = 2*M_PI*heading/8;
+        testGrid.set_sensing_mode(exactSensing);
+        double exactRight = testGrid.average_pheromones(foodChannel, rightSide, location, orientation, 12);
+        double exactLeft = testGrid.average_pheromones(foodChannel, leftSide, location, orientation, 12);
+
+        testGrid.set_sensing_mode(stencilSensing);
+        EXPECT_NEAR(testGrid.average_pheromones(foodChannel, rightSide, location, orientation, 12), exactRight, 2);
+        EXPECT_NEAR(testGrid.average_pheromones(foodChannel, leftSide, location, orientation, 12), exactLeft, 2);
+    }
+}
+
+TEST(StencilSensing, GivenALinearPheromoneField_WhenSensingWithStencilsAtAnyHeading_ExpectCloseToTheExactAverage)
+{
+    PheromoneGrid testGrid{100,100,1};
+    for (int x = 0; x <= 100; x++)
+    {
+        for (int y = 0; y <= 100; y++)
+        {
+            testGrid.add_home_pheromone(x,y,10*x + 3*y);
+        }
+    }
+    testGrid.build_sensing_stencils(12, 256);
+
+    for (double orientation = -1; orientation < 7; orientation += 0.37)
+    {
+        Vector3D location(50.6,49.3,0);
+        testGrid.set_sensing_mode(exactSensing);
+        double exactRight = testGrid.average_home_pheromones_right(location, orientation, 12);
+        testGrid.set_sensing_mode(stencilSensing);
+        EXPECT_NEAR(testGrid.average_home_pheromones_right(location, orientation, 12), exactRight, 15);
+    }
+}
+
 TEST(ClearPheromones, AfterClearingPheromonesOnPheromoneGridWithHomePheromones_WhenGettingPheromoneValues_ExpectZeros)
 {
     PheromoneGrid testGrid{20,20,5};
@@ -1013,6 +2281,97 @@ TEST(ClearPheromones, AfterClearingPheromonesOnPheromoneGridWithFoodPheromones_W
     EXPECT_EQ(pheromoneValue2, 0);
 }
 
+TEST(MergePheromoneDeposits, GivenTwoDepositBuffers_AfterMergingInTwoRanges_ExpectSameValuesAsSpreadingDirectly)
+{
+    PheromoneGrid directGrid{100,100,1};
+    PheromoneGrid mergedGrid{100,100,1};
+    PheromoneGrid* grids[] = {&directGrid, &mergedGrid};
+    for (int i = 0; i < 2; i++)
+    {
+        grids[i]->set_lazy_decay(true);
+        grids[i]->spread_home_pheromone(21,20,5000,3);
+        grids[i]->decay_all_pheromones();
+        grids[i]->decay_all_pheromones();
+    }
+    int tileRows = mergedGrid.get_tile_rows();
+    std::vector<PheromoneDeposits> deposits(2);
+    deposits[0].resize(tileRows);
+    deposits[1].resize(tileRows);
+
+    directGrid.spread_home_pheromone(20,20,50,3);
+    directGrid.spread_home_pheromone(22,31,70,3);
+    directGrid.spread_food_pheromone(60,80,90,3);
+    directGrid.spread_food_pheromone(1,50,30,3);
+    deposits[0].spread_home_pheromone(mergedGrid,20,20,50,3);
+    deposits[1].spread_home_pheromone(mergedGrid,22,31,70,3);
+    deposits[1].spread_food_pheromone(mergedGrid,60,80,90,3);
+    deposits[0].spread_food_pheromone(mergedGrid,1,50,30,3);
+
+    mergedGrid.merge_deposits(deposits, 0, tileRows/2);
+    mergedGrid.merge_deposits(deposits, tileRows/2, tileRows);
+    mergedGrid.finish_deposits(deposits);
+
+    EXPECT_EQ(mergedGrid.get_home_pheromones(), directGrid.get_home_pheromones());
+    EXPECT_EQ(mergedGrid.get_food_pheromones(), directGrid.get_food_pheromones());
+    EXPECT_EQ(mergedGrid.get_active_tile_count(), directGrid.get_active_tile_count());
+    EXPECT_TRUE(deposits[0].empty());
+    EXPECT_TRUE(deposits[1].empty());
+}
+
+TEST(MergePheromoneDeposits, GivenAScaledGrid_AfterSpreadingInsideAndAcrossTheEdges_ExpectSameValuesAsSpreadingDirectly)
+{
+    PheromoneGrid directGrid{200,150,3};
+    PheromoneGrid mergedGrid{200,150,3};
+    std::vector<PheromoneDeposits> deposits(1);
+    deposits[0].resize(mergedGrid.get_tile_rows());
+
+    std::vector<std::vector<int>> spreads{{100,70,5,3}, {101,71,9,4}, {2,60,11,3}, {198,100,13,4}, {20,4,17,5}, {95,96,19,1}};
+    for (int i = 0; i < spreads.size(); i++)
+    {
+        directGrid.spread_home_pheromone(spreads[i][0],spreads[i][1],spreads[i][2],spreads[i][3]);
+        deposits[0].spread_home_pheromone(mergedGrid,spreads[i][0],spreads[i][1],spreads[i][2],spreads[i][3]);
+    }
+
+    mergedGrid.merge_deposits(deposits, 0, mergedGrid.get_tile_rows());
+    mergedGrid.finish_deposits(deposits);
+
+    EXPECT_EQ(mergedGrid.get_home_pheromones(), directGrid.get_home_pheromones());
+    EXPECT_EQ(mergedGrid.get_active_tile_count(), directGrid.get_active_tile_count());
+}
+
+TEST(MergePheromoneDeposits, GivenDepositsWithinSpreadOfTheTopEdge_AfterMerging_ExpectOnlyTheCellsOnTheGrid)
+{
+    PheromoneGrid directGrid{100,100,1};
+    PheromoneGrid mergedGrid{100,100,1};
+    std::vector<PheromoneDeposits> deposits(1);
+    deposits[0].resize(mergedGrid.get_tile_rows());
+
+    directGrid.spread_home_pheromone(1,1,10,3);
+    directGrid.spread_food_pheromone(50,0,20,3);
+    directGrid.spread_food_pheromone(99,99,30,3);
+    deposits[0].spread_home_pheromone(mergedGrid,1,1,10,3);
+    deposits[0].spread_food_pheromone(mergedGrid,50,0,20,3);
+    deposits[0].spread_food_pheromone(mergedGrid,99,99,30,3);
+    mergedGrid.merge_deposits(deposits, 0, mergedGrid.get_tile_rows());
+    mergedGrid.finish_deposits(deposits);
+
+    std::vector<int> home = mergedGrid.get_home_pheromones();
+    std::vector<int> food = mergedGrid.get_food_pheromones();
+    long long homeSum = 0;
+    long long foodSum = 0;
+    for (int i = 0; i < home.size(); i++)
+    {
+        homeSum += home[i];
+        foodSum += food[i];
+    }
+    EXPECT_EQ(homeSum, 4*4*10);
+    EXPECT_EQ(foodSum, 6*3*20 + 5*5*30);
+    EXPECT_EQ(mergedGrid.get_home_pheromone(100,0), 0);
+    EXPECT_EQ(mergedGrid.get_home_pheromone(3,3), 10);
+    EXPECT_EQ(home, directGrid.get_home_pheromones());
+    EXPECT_EQ(food, directGrid.get_food_pheromones());
+}
+
 //############################################################
 //ObstacleGrid Tests
 //############################################################
@@ -1246,6 +2605,356 @@ TEST_F(TestObstacles, GivenAnObstacleGridAndALocationTwoAwayFromObstacle_WhenChe
     EXPECT_EQ(calcDistance, goldDistance);
 }
 
+TEST(ObstacleWordScan, GivenScatteredObstacles_WhenCheckingObstacleDistanceAtManyAngles_ExpectSameAsSteppingOneCellAtATime)
+{
+    ObstacleGrid testGrid{300,200};
+    testGrid.fill_borders();
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<double> xValues(5, 295);
+    std::uniform_real_distribution<double> yValues(5, 195);
+    std::uniform_real_distribution<double> angles(-7, 7);
+    for (int i = 0; i < 60; i++)
+    {
+        testGrid.add_obstacle_circle(xValues(generator), yValues(generator), 4);
+        testGrid.fill_square(xValues(generator), yValues(generator));
+    }
+
+    int detectionRange{40};
+    for (int i = 0; i < 3000; i++)
+    {
+        Vector3D location(xValues(generator), yValues(generator), 0);
+        double orientation = i % 10 == 0 ? (i/10 % 8)*M_PI/4 : angles(generator);
+
+        int goldDistance{0};
+        while (goldDistance <= detectionRange && !testGrid.check_obstacle(location[0] + goldDistance*cos(orientation), location[1] + goldDistance*sin(orientation)))
+        {
+            goldDistance++;
+        }
+
+        EXPECT_EQ(testGrid.check_for_obstacle_front(location, orientation, detectionRange), goldDistance <= detectionRange);
+        EXPECT_EQ(testGrid.check_obstacle_distance(location, orientation, detectionRange), std::min(goldDistance, detectionRange));
+    }
+}
+
+TEST(ObstacleWordScan, GivenAnObstacle_WhenReadingTheRawWords_ExpectOneBitInAPaddedRow)
+{
+    ObstacleGrid testGrid{99,10};
+    testGrid.add_obstacle(70,4);
+    const std::vector<std::uint64_t>& words = testGrid.get_obstacle_words();
+
+    ASSERT_EQ(testGrid.get_words_per_row(), 2);
+    EXPECT_EQ(words.size(), 2*11);
+    EXPECT_EQ(words[4*2 + 1], std::uint64_t(1) << 6);
+    EXPECT_EQ(testGrid.get_obstacle_vector()[4*100 + 70], true);
+    EXPECT_EQ(testGrid.get_obstacle_locations().size(), 1);
+}
+
+TEST(ObstacleWordScan, GivenRandomObstacles_WhenCountingNeighborWalls_ExpectSameAsCountingEachNeighbor)
+{
+    ObstacleGrid testGrid{200,150};
+    testGrid.randomly_fill_map(43);
+    std::vector<bool> obstacleVector = testGrid.get_obstacle_vector();
+    int gridWidth{201};
+    int gridHeight{151};
+
+    for (int x = 0; x < gridWidth; x += 7)
+    {
+        for (int y = 0; y < gridHeight; y += 3)
+        {
+            double goldCount{0};
+            for (int neighbourX = x - 10; neighbourX <= x + 10; neighbourX += 5)
+            {
+                for (int neighbourY = y - 10; neighbourY <= y + 10; neighbourY += 5)
+                {
+                    if (neighbourX < 0 || neighbourX >= gridWidth || neighbourY < 0 || neighbourY >= gridHeight)
+                    {
+                        goldCount++;
+                    }
+                    else if (neighbourX != x || neighbourY != y)
+                    {
+                        goldCount += obstacleVector[neighbourY*gridWidth + neighbourX];
+                    }
+                }
+            }
+            EXPECT_EQ(testGrid.get_neighbor_wall_count(x, y, testGrid.get_obstacle_words()), goldCount);
+        }
+    }
+}
+
+TEST(ObstacleDistanceField, GivenRandomObstacles_WhenBuildingTheDistanceField_ExpectTheFlooredDistanceToTheNearestBlockedCell)
+{
+    ObstacleGrid testGrid{90,70};
+    std::mt19937 generator(3);
+    std::uniform_int_distribution<int> xValues(0, 90);
+    std::uniform_int_distribution<int> yValues(0, 70);
+    for (int i = 0; i < 25; i++)
+    {
+        testGrid.add_obstacle(xValues(generator), yValues(generator));
+    }
+    testGrid.set_distance_field_enabled(true);
+
+    for (int row = 0; row <= 70; row++)
+    {
+        for (int column = 0; column <= 90; column++)
+        {
+            int goldSquaredDistance = std::min(std::min(column + 1, 91 - column), std::min(row + 1, 71 - row));
+            goldSquaredDistance *= goldSquaredDistance;
+            for (int obstacleRow = 0; obstacleRow <= 70; obstacleRow++)
+            {
+                for (int obstacleColumn = 0; obstacleColumn <= 90; obstacleColumn++)
+                {
+                    if (testGrid.is_blocked(obstacleColumn, obstacleRow))
+                    {
+                        int dx = column - obstacleColumn;
+                        int dy = row - obstacleRow;
+                        goldSquaredDistance = std::min(goldSquaredDistance, dx*dx + dy*dy);
+                    }
+                }
+            }
+            EXPECT_EQ(testGrid.get_clearance(column, row), int(floor(sqrt(double(goldSquaredDistance)) + 1e-9)));
+        }
+    }
+}
+
+TEST(ObstacleDistanceField, GivenScatteredObstacles_WhenSphereTracingAtManyAngles_ExpectSameAsSteppingOneCellAtATime)
+{
+    ObstacleGrid testGrid{300,200};
+    testGrid.fill_borders();
+    std::mt19937 generator(12);
+    std::uniform_real_distribution<double> xValues(-3, 303);
+    std::uniform_real_distribution<double> yValues(-3, 203);
+    std::uniform_real_distribution<double> angles(-7, 7);
+    for (int i = 0; i < 40; i++)
+    {
+        testGrid.add_obstacle_circle(xValues(generator), yValues(generator), 3);
+    }
+    testGrid.erase(2,100,4);
+    testGrid.set_distance_field_enabled(true);
+    ASSERT_TRUE(testGrid.is_distance_field_current());
+
+    int detectionRange{60};
+    for (int i = 0; i < 5000; i++)
+    {
+        Vector3D location(xValues(generator), yValues(generator), 0);
+        double orientation = angles(generator);
+
+        int goldDistance{0};
+        while (goldDistance <= detectionRange && !testGrid.check_obstacle(location[0] + goldDistance*cos(orientation), location[1] + goldDistance*sin(orientation)))
+        {
+            goldDistance++;
+        }
+
+        EXPECT_EQ(testGrid.check_obstacle_distance(location, orientation, detectionRange), std::min(goldDistance, detectionRange));
+    }
+}
+
+TEST(ObstacleDistanceField, GivenAnEditAfterBuilding_WhenCheckingTheField_ExpectItNoLongerCurrent)
+{
+    ObstacleGrid testGrid{100,100};
+    testGrid.set_distance_field_enabled(true);
+    EXPECT_TRUE(testGrid.is_distance_field_current());
+
+    testGrid.add_obstacle_circle(50,50,5);
+
+    EXPECT_FALSE(testGrid.is_distance_field_current());
+    EXPECT_TRUE(testGrid.check_for_obstacle_front(Vector3D(40,50,0), 0, 10));
+}
+
+TEST(ObstacleDistanceField, GivenABrushStroke_WhenCheckingTheDirtyRegion_ExpectItToCoverTheStroke)
+{
+    ObstacleGrid testGrid{200,200};
+    testGrid.set_distance_field_enabled(true);
+    EXPECT_FALSE(testGrid.has_dirty_region());
+
+    testGrid.add_obstacle_line(60,70,90,80,2);
+
+    int firstColumn, firstRow, lastColumn, lastRow;
+    ASSERT_TRUE(testGrid.has_dirty_region());
+    testGrid.get_dirty_region(firstColumn, firstRow, lastColumn, lastRow);
+    EXPECT_LE(firstColumn, 60);
+    EXPECT_GE(lastColumn, 91);
+    EXPECT_LE(firstRow, 70);
+    EXPECT_GE(lastRow, 81);
+    EXPECT_LT(lastColumn - firstColumn, 40);
+    EXPECT_LT(lastRow - firstRow, 20);
+}
+
+TEST(ObstacleDistanceField, GivenALargeGrid_AfterAddingAndErasingWalls_ExpectRepairOnlyTheStrokeAndMatchAFullBuild)
+{
+    ObstacleGrid repairedGrid{1999,1999};
+    repairedGrid.fill_borders();
+    repairedGrid.add_obstacle_circle(1000,900,20);
+    repairedGrid.set_distance_field_enabled(true);
+
+    repairedGrid.add_obstacle_line(960,1020,1040,1060,3);
+    repairedGrid.erase(1000,900,12);
+    repairedGrid.prepare_distance_field();
+    int firstColumn, lastColumn, firstRow, lastRow;
+    repairedGrid.get_distance_update_columns(firstColumn, lastColumn);
+    repairedGrid.get_distance_update_rows(firstRow, lastRow);
+    EXPECT_GT(firstColumn, 0);
+    EXPECT_LT(lastColumn, 2000);
+    EXPECT_GT(firstRow, 0);
+    EXPECT_LT(lastRow, 2000);
+    repairedGrid.build_distance_columns(firstColumn, lastColumn);
+    repairedGrid.build_distance_rows(firstRow, lastRow);
+    repairedGrid.finish_distance_field();
+
+    ObstacleGrid rebuiltGrid{1999,1999};
+    rebuiltGrid.fill_borders();
+    rebuiltGrid.add_obstacle_circle(1000,900,20);
+    rebuiltGrid.add_obstacle_line(960,1020,1040,1060,3);
+    rebuiltGrid.erase(1000,900,12);
+    rebuiltGrid.set_distance_field_enabled(true);
+
+    int mismatches{0};
+    for (int row = 0; row < 2000; row++)
+    {
+        for (int column = 0; column < 2000; column++)
+        {
+            mismatches += repairedGrid.get_clearance(column, row) != rebuiltGrid.get_clearance(column, row);
+        }
+    }
+    EXPECT_EQ(mismatches, 0);
+}
+
+TEST(ObstacleDistanceField, GivenALowClearanceLimit_AfterABrushStroke_ExpectRepairBoundedByTheLimitAndMatchAFullBuild)
+{
+    const int limit = 31;
+    ObstacleGrid repairedGrid{999,999};
+    repairedGrid.fill_borders();
+    repairedGrid.add_obstacle_circle(300,300,20);
+    repairedGrid.set_clearance_limit(limit);
+    repairedGrid.set_distance_field_enabled(true);
+
+    repairedGrid.add_obstacle_circle(500,500,4);
+    repairedGrid.prepare_distance_field();
+    int firstColumn, lastColumn, firstRow, lastRow;
+    repairedGrid.get_distance_update_columns(firstColumn, lastColumn);
+    repairedGrid.get_distance_update_rows(firstRow, lastRow);
+    EXPECT_GE(firstColumn, 500 - 5 - 2*(limit + 1));
+    EXPECT_LE(lastColumn, 500 + 6 + 2*(limit + 1));
+    EXPECT_GE(firstRow, 500 - 5 - (limit + 1));
+    EXPECT_LE(lastRow, 500 + 6 + (limit + 1));
+    repairedGrid.build_distance_columns(firstColumn, lastColumn);
+    repairedGrid.build_distance_rows(firstRow, lastRow);
+    repairedGrid.finish_distance_field();
+
+    ObstacleGrid rebuiltGrid{999,999};
+    rebuiltGrid.fill_borders();
+    rebuiltGrid.add_obstacle_circle(300,300,20);
+    rebuiltGrid.add_obstacle_circle(500,500,4);
+    rebuiltGrid.set_clearance_limit(limit);
+    rebuiltGrid.set_distance_field_enabled(true);
+
+    int mismatches{0};
+    int largest{0};
+    for (int row = 0; row < 1000; row++)
+    {
+        for (int column = 0; column < 1000; column++)
+        {
+            mismatches += repairedGrid.get_clearance(column, row) != rebuiltGrid.get_clearance(column, row);
+            largest = std::max(largest, repairedGrid.get_clearance(column, row));
+        }
+    }
+    EXPECT_EQ(mismatches, 0);
+    EXPECT_EQ(largest, limit);
+}
+
+TEST(ObstacleRaycast, GivenTwoDiagonalWallCells_WhenCastingBetweenThem_ExpectOnlyTheTraversalToHit)
+{
+    ObstacleGrid testGrid{40,40};
+    testGrid.add_obstacle(10,11);
+    testGrid.add_obstacle(11,10);
+    Vector3D location(5,5,0);
+    double orientation = atan2(1.0, 1.0);
+
+    EXPECT_FALSE(testGrid.check_for_obstacle_front(location, orientation, 15));
+    testGrid.set_raycast_mode(traversalRaycast);
+    EXPECT_TRUE(testGrid.check_for_obstacle_front(location, orientation, 15));
+
+    RayHit hit = testGrid.cast_ray(location, orientation, 15);
+    EXPECT_TRUE(hit.blocked);
+    EXPECT_TRUE((hit.column == 10 && hit.row == 11) || (hit.column == 11 && hit.row == 10));
+    EXPECT_NEAR(hit.distance, 5.5*sqrt(2.0), 1e-9);
+}
+
+TEST(ObstacleRaycast, GivenRandomObstacles_WhenCastingRays_ExpectTheFirstBlockedCellOfAFinelySampledRay)
+{
+    ObstacleGrid testGrid{150,120};
+    std::mt19937 generator(21);
+    std::uniform_real_distribution<double> xValues(0, 150);
+    std::uniform_real_distribution<double> yValues(0, 120);
+    std::uniform_real_distribution<double> angles(-7, 7);
+    for (int i = 0; i < 300; i++)
+    {
+        testGrid.add_obstacle(int(xValues(generator)), int(yValues(generator)));
+    }
+
+    int detectionRange{40};
+    for (int i = 0; i < 2000; i++)
+    {
+        Vector3D location(xValues(generator), yValues(generator), 0);
+        double orientation = angles(generator);
+        RayHit hit = testGrid.cast_ray(location, orientation, detectionRange);
+
+        double goldDistance{0};
+        int goldColumn = int(floor(location[0] + .5));
+        int goldRow = int(floor(location[1] + .5));
+        while (goldDistance <= detectionRange && !testGrid.is_blocked(goldColumn, goldRow))
+        {
+            goldDistance += 1e-3;
+            goldColumn = int(floor(location[0] + goldDistance*cos(orientation) + .5));
+            goldRow = int(floor(location[1] + goldDistance*sin(orientation) + .5));
+        }
+
+        ASSERT_EQ(hit.blocked, goldDistance <= detectionRange);
+        if (hit.blocked)
+        {
+            EXPECT_EQ(hit.column, goldColumn);
+            EXPECT_EQ(hit.row, goldRow);
+            EXPECT_NEAR(hit.distance, goldDistance, 2e-3);
+        }
+    }
+}
+
+TEST(ObstacleRaycast, GivenScatteredObstacles_WhenCastingWithTheDistanceField_ExpectTheSameHits)
+{
+    ObstacleGrid testGrid{400,300};
+    testGrid.fill_borders();
+    std::mt19937 generator(4);
+    std::uniform_real_distribution<double> xValues(0, 400);
+    std::uniform_real_distribution<double> yValues(0, 300);
+    std::uniform_real_distribution<double> angles(-7, 7);
+    for (int i = 0; i < 30; i++)
+    {
+        testGrid.add_obstacle_circle(xValues(generator), yValues(generator), 4);
+    }
+
+    std::vector<Vector3D> locations;
+    std::vector<double> orientations;
+    std::vector<RayHit> hits;
+    for (int i = 0; i < 3000; i++)
+    {
+        locations.push_back(Vector3D(xValues(generator), yValues(generator), 0));
+        orientations.push_back(angles(generator));
+        hits.push_back(testGrid.cast_ray(locations[i], orientations[i], 120));
+    }
+
+    testGrid.set_distance_field_enabled(true);
+    for (int i = 0; i < 3000; i++)
+    {
+        RayHit hit = testGrid.cast_ray(locations[i], orientations[i], 120);
+        ASSERT_EQ(hit.blocked, hits[i].blocked);
+        if (hit.blocked)
+        {
+            EXPECT_EQ(hit.column, hits[i].column);
+            EXPECT_EQ(hit.row, hits[i].row);
+            EXPECT_NEAR(hit.distance, hits[i].distance, 1e-9);
+        }
+    }
+}
+
 TEST(AddObstacleCircle, AfterAddingObstacleCircleToEmptyGrid_WhenCheckingIfObstaclesAtLocation_ExpectTrue)
 {
     ObstacleGrid testGrid{100,100};
@@ -94,3 +94,23 @@ double dot_product(const Vector3D v1, const Vector3D v2)
 {
     return v1[0]*v2[0] + v1[1]*v2[1] + v1[2]*v2[2];
 }
+
+// Squared distance in the xy-plane from a point to the segment start-end. A
+// segment with equal ends is a point, so this also covers circles.
+double distance_squared_to_segment(const Vector3D point, const Vector3D start, const Vector3D end)
+{
+    double segmentX = end[0] - start[0];
+    double segmentY = end[1] - start[1];
+    double offsetX = point[0] - start[0];
+    double offsetY = point[1] - start[1];
+    double segmentLengthSquared = segmentX*segmentX + segmentY*segmentY;
+    double t = 0;
+    if (segmentLengthSquared > 0)
+    {
+        t = (offsetX*segmentX + offsetY*segmentY)/segmentLengthSquared;
+        t = t < 0 ? 0 : (t > 1 ? 1 : t);
+    }
+    double dx = offsetX - t*segmentX;
+    double dy = offsetY - t*segmentY;
+    return dx*dx + dy*dy;
+}
@@ -29,5 +29,6 @@ double length(const Vector3D v1);
 Vector3D normalize(const Vector3D v1);
 Vector3D cross_product(const Vector3D v1, const Vector3D v2);
 double dot_product(const Vector3D v1, const Vector3D v2);
+double distance_squared_to_segment(const Vector3D point, const Vector3D start, const Vector3D end);
 
 #endif
@@ -0,0 +1,153 @@
+#include "workerpool.hpp"
+
+WorkerPool::WorkerPool(){}
+
+WorkerPool::WorkerPool(const int& threadCount)
+{
+    set_thread_count(threadCount);
+}
+
+WorkerPool::WorkerPool(const WorkerPool& other)
+{
+    set_thread_count(other.get_thread_count());
+}
+
+WorkerPool& WorkerPool::operator=(const WorkerPool& other)
+{
+    if (this != &other)
+    {
+        set_thread_count(other.get_thread_count());
+    }
+    return *this;
+}
+
+WorkerPool::~WorkerPool()
+{
+    stop_threads();
+}
+
+int WorkerPool::get_thread_count() const
+{
+    return threadCount;
+}
+
+void WorkerPool::set_thread_count(const int& newThreadCount)
+{
+    int clampedCount = newThreadCount < 1 ? 1 : newThreadCount;
+    if (clampedCount == threadCount)
+    {
+        return;
+    }
+    stop_threads();
+    threadCount = clampedCount;
+    start_threads();
+}
+
+void WorkerPool::get_chunk(const int& count, const int& alignment, const int& worker, int& begin, int& end) const
+{
+    int blocks = (count + alignment - 1)/alignment;
+    int blocksPerWorker = blocks/threadCount;
+    int extraBlocks = blocks%threadCount;
+
+    int firstBlock = worker*blocksPerWorker + (worker < extraBlocks ? worker : extraBlocks);
+    int lastBlock = firstBlock + blocksPerWorker + (worker < extraBlocks ? 1 : 0);
+
+    begin = firstBlock*alignment;
+    end = lastBlock*alignment;
+    if (begin > count)
+    {
+        begin = count;
+    }
+    if (end > count)
+    {
+        end = count;
+    }
+}
+
+void WorkerPool::parallel_for(const int& count, const RangeTask& task, const int& alignment)
+{
+    if (threadCount == 1 || count <= alignment)
+    {
+        task(0, count, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        currentTask = &task;
+        currentCount = count;
+        currentAlignment = alignment;
+        workersRemaining = threadCount - 1;
+        jobGeneration++;
+    }
+    jobReady.notify_all();
+
+    int begin;
+    int end;
+    get_chunk(count, alignment, 0, begin, end);
+    task(begin, end, 0);
+
+    std::unique_lock<std::mutex> lock(jobMutex);
+    jobDone.wait(lock, [this]{ return workersRemaining == 0; });
+    currentTask = nullptr;
+}
+
+void WorkerPool::start_threads()
+{
+    stopping = false;
+    for (int worker = 1; worker < threadCount; worker++)
+    {
+        threads.push_back(std::thread(&WorkerPool::worker_loop, this, worker, jobGeneration));
+    }
+}
+
+void WorkerPool::stop_threads()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (int i = 0; i < threads.size(); i++)
+    {
+        threads[i].join();
+    }
+    threads.clear();
+}
+
+void WorkerPool::worker_loop(const int& worker, const unsigned long& startGeneration)
+{
+    unsigned long seenGeneration = startGeneration;
+    while (true)
+    {
+        const RangeTask* task;
+        int count;
+        int alignment;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobReady.wait(lock, [this, &seenGeneration]{ return stopping || jobGeneration != seenGeneration; });
+            if (stopping)
+            {
+                return;
+            }
+            seenGeneration = jobGeneration;
+            task = currentTask;
+            count = currentCount;
+            alignment = currentAlignment;
+        }
+
+        int begin;
+        int end;
+        get_chunk(count, alignment, worker, begin, end);
+        if (begin < end)
+        {
+            (*task)(begin, end, worker);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            workersRemaining--;
+        }
+        jobDone.notify_one();
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef WORKERPOOL_HPP
+#define WORKERPOOL_HPP
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that split an index range into one contiguous
+// chunk per thread. The calling thread always runs the first chunk, so a pool
+// with a thread count of one runs everything inline.
+class WorkerPool
+{
+public:
+    typedef std::function<void(int begin, int end, int worker)> RangeTask;
+
+    WorkerPool();
+    explicit WorkerPool(const int& threadCount);
+    WorkerPool(const WorkerPool& other);
+    WorkerPool& operator=(const WorkerPool& other);
+    ~WorkerPool();
+
+    int get_thread_count() const;
+    void set_thread_count(const int& threadCount);
+
+    void parallel_for(const int& count, const RangeTask& task, const int& alignment = 1);
+    void get_chunk(const int& count, const int& alignment, const int& worker, int& begin, int& end) const;
+
+private:
+    void start_threads();
+    void stop_threads();
+    void worker_loop(const int& worker, const unsigned long& startGeneration);
+
+    int threadCount{1};
+    std::vector<std::thread> threads;
+
+    std::mutex jobMutex;
+    std::condition_variable jobReady;
+    std::condition_variable jobDone;
+    const RangeTask* currentTask{nullptr};
+    int currentCount{0};
+    int currentAlignment{1};
+    unsigned long jobGeneration{0};
+    int workersRemaining{0};
+    bool stopping{false};
+};
+
+#endif // WORKERPOOL_HPP
@@ -1,58 +1,390 @@
 #include "world.hpp"
+#include "statehash.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <math.h>
 #include <random>
 
 
-World::World()
+namespace
+{
+// Stream ids for the counter-based generator. Per-ant counters are the tick in
+// the high 32 bits and the ant index in the low 32 bits.
+const std::uint64_t wanderRollStream = 0;
+const std::uint64_t cornerRollStream = 1;
+const std::uint64_t caveStream = 2;
+}
+
+World::World(): randomStreams(std::random_device{}())
 {
     height = 100;
     width = 100;
     pheromones = PheromoneGrid(width, height, pheromoneGridScaling);
     obstacles = ObstacleGrid{height,width};
+    foodIndex = FoodIndex(width, height, Ant::get_sight_range());
     obstacles.fill_borders();
 }
 
-World::World(const int& worldWidth, const int& worldHeight)
+World::World(const int& worldWidth, const int& worldHeight): World(worldWidth, worldHeight, libmTrig)
+{
+}
+
+World::World(const int& worldWidth, const int& worldHeight, const TrigMode& trigMode):
+    trigMode(trigMode), randomStreams(std::random_device{}())
 {
     height = worldHeight;
     width = worldWidth;
     pheromones = PheromoneGrid(width, height, pheromoneGridScaling);
+    pheromones.set_trig_mode(trigMode);
     obstacles = ObstacleGrid{width,height};
+    foodIndex = FoodIndex(width, height, Ant::get_sight_range());
+    obstacles.set_trig_mode(trigMode);
     obstacles.fill_borders();
 }
 
 void World::update()
 {
-    move_ants();
-    turn_ants();
-    add_ant_pheromones();
+    if (updateMode == fusedUpdate)
+    {
+        update_fused();
+        return;
+    }
+    for (int phase = 0; phase < updatePhaseCount; phase++)
+    {
+        run_phase(UpdatePhase(phase));
+    }
+}
+
+// Running every phase in order is one update(); callers that time or skip
+// phases drive them one at a time. Finishing resetPhase completes a tick in
+// stats().
+void World::run_phase(const UpdatePhase& phase)
+{
+    start_stats_phase();
+    switch (phase)
+    {
+    case movePhase:
+        move_ants();
+        break;
+    case turnPhase:
+        turn_ants();
+        break;
+    case depositPhase:
+        add_ant_pheromones();
+        break;
+    case decayPhase:
+        decay_pheromones();
+        break;
+    case collectPhase:
+        collect_food();
+        break;
+    case dropPhase:
+        drop_food();
+        break;
+    case diminishPhase:
+        diminish_ant_pheromone_strengths();
+        break;
+    case resetPhase:
+        reset_ant_pheromone_strengths();
+        break;
+    default:
+        return;
+    }
+    finish_stats_phase(phase);
+}
+
+// One parallel pass over the ants does move, turn and deposit, then drop,
+// diminish and reset for every ant that cannot pick up food this tick. Piles
+// only shrink while food is collected, so an ant with no pile in reach before
+// collection has none after it either. The few ants that do have one are
+// finished afterwards in ant order, exactly as collect_food() would. Deposits
+// go through the worker buffers, so no ant senses this tick's pheromone, and
+// decay still runs between the deposits and the pickups. The result matches
+// the phased update bit for bit.
+void World::update_fused()
+{
+    start_stats_phase();
+    prepare_ant_turns();
+    prepare_deposit_buffers();
+    // A worker left without ants never runs the task below, so every list is
+    // cleared here rather than by its worker.
+    pickupCandidates.resize(workerPool.get_thread_count());
+    for (int worker = 0; worker < pickupCandidates.size(); worker++)
+    {
+        pickupCandidates[worker].clear();
+    }
+
+    // Chunks are aligned to whole hasFood words so workers never write the
+    // same word.
+    std::uint64_t firstCounter = randomTick << 32;
+    workerPool.parallel_for(ants.size(), [this, firstCounter](int begin, int end, int worker)
+    {
+        randomStreams.fill_unit(wanderRollStream, firstCounter + begin, wanderRolls.data() + begin, end - begin);
+        randomStreams.fill_unit(cornerRollStream, firstCounter + begin, cornerRolls.data() + begin, end - begin);
+        update_ant_range(begin, end, depositBuffers[worker], pickupCandidates[worker]);
+        statsRecorder.collect_thread_counters(worker);
+    }, 64);
+    randomTick++;
+    finish_stats_phase(turnPhase);
+
+    merge_deposit_buffers();
+    finish_stats_phase(depositPhase);
     decay_pheromones();
-    collect_food();
-    drop_food();
-    diminish_ant_pheromone_strengths();
-    reset_ant_pheromone_strengths();
+    finish_stats_phase(decayPhase);
+
+    // Workers own consecutive chunks, so walking their lists in order visits
+    // the candidates in ant order.
+    for (int worker = 0; worker < pickupCandidates.size(); worker++)
+    {
+        for (int i = 0; i < pickupCandidates[worker].size(); i++)
+        {
+            collect_food_for(pickupCandidates[worker][i]);
+            finish_ant(pickupCandidates[worker][i]);
+        }
+    }
+    finish_stats_phase(collectPhase);
+    finish_stats_phase(resetPhase);
+}
+
+void World::update_ant_range(const int& begin, const int& end, PheromoneDeposits& deposits, std::vector<int>& candidates)
+{
+    std::vector<double>& xPositions = ants.get_x_positions();
+    std::vector<double>& yPositions = ants.get_y_positions();
+    std::vector<double>& orientations = ants.get_orientations();
+    const std::vector<double>& pheromoneStrengths = ants.get_pheromone_strengths();
+
+    for (int i = begin; i < end; i++)
+    {
+        bool hasFood = ants.has_food(i);
+        Ant ant{Vector3D(xPositions[i], yPositions[i], 0), orientations[i]};
+        ant.set_trig_mode(trigMode);
+        ant.move();
+        ant.turn_if_at_boundary(width, height);
+        ant.set_has_food(hasFood);
+        ant.turn(pheromones, obstacles, foodIndex, colony, wanderRolls[i], cornerRolls[i]);
+
+        Vector3D location = ant.get_location();
+        xPositions[i] = location[0];
+        yPositions[i] = location[1];
+        orientations[i] = ant.get_orientation();
+
+        int x = location[0];
+        int y = location[1];
+        int pheromoneAddValue = pheromoneStrengths[i];
+        if (hasFood)
+        {
+            deposits.spread_food_pheromone(pheromones,x,y,pheromoneAddValue,pheromoneSpread);
+        }
+        else
+        {
+            deposits.spread_home_pheromone(pheromones,x,y,pheromoneAddValue,pheromoneSpread);
+        }
+
+        if (!hasFood && foodIndex.find_nearest(location[0], location[1], reachForFood) >= 0)
+        {
+            candidates.push_back(i);
+        }
+        else
+        {
+            finish_ant(i);
+        }
+    }
+}
+
+// drop_food(), diminish_ant_pheromone_strengths() and
+// reset_ant_pheromone_strengths() for one ant.
+void World::finish_ant(const int& index)
+{
+    std::vector<double>& orientations = ants.get_orientations();
+    std::vector<double>& pheromoneStrengths = ants.get_pheromone_strengths();
+    Vector3D colonyLocation = colony.get_location();
+    double colonyDistanceX = std::abs(ants.get_x_positions()[index] - colonyLocation[0]);
+    double colonyDistanceY = std::abs(ants.get_y_positions()[index] - colonyLocation[1]);
+
+    if (ants.has_food(index) && colonyDistanceX < reachForFood && colonyDistanceY < reachForFood)
+    {
+        ants.set_has_food(index, false);
+        orientations[index] += 3.14;
+        pheromoneStrengths[index] = Ant::get_max_pheromone_strength();
+        ANTSIM_COUNT(foodDropsCounter, 1);
+    }
+
+    double diminishValue = Ant::get_diminish_pheromone_value();
+    pheromoneStrengths[index] = pheromoneStrengths[index] > diminishValue ? pheromoneStrengths[index] - diminishValue : 0;
+
+    if (!ants.has_food(index) && colonyDistanceX < resetPheromoneDistance && colonyDistanceY < resetPheromoneDistance)
+    {
+        pheromoneStrengths[index] = Ant::get_max_pheromone_strength();
+    }
+}
+
+void World::start_stats_phase()
+{
+#ifdef ANTSIM_STATS
+    statsRecorder.discard_thread_counters();
+    phaseStart = std::chrono::steady_clock::now();
+#endif
+}
+
+// Finishing resetPhase completes the tick.
+void World::finish_stats_phase(const UpdatePhase& phase)
+{
+#ifdef ANTSIM_STATS
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    statsRecorder.collect_thread_counters(0);
+    statsRecorder.finish_phase(phase, std::chrono::duration<double, std::milli>(now - phaseStart).count());
+    phaseStart = now;
+    if (phase == resetPhase)
+    {
+        statsRecorder.finish_tick();
+    }
+#else
+    (void)phase;
+#endif
+}
+
+UpdateMode World::get_update_mode()
+{
+    return updateMode;
 }
 
-int World::get_height()
+void World::set_update_mode(const UpdateMode& mode)
+{
+    updateMode = mode;
+}
+
+// Phase times and counters for the last tick, averaged over the last
+// StatsRecorder::statsWindow ticks, and totalled since the last clear. All
+// zero when built without ANTSIM_STATS. A fused update reports its ant pass
+// as turnPhase and its serial pickups as collectPhase.
+SimulationStats World::stats() const
+{
+    return statsRecorder.get_snapshot();
+}
+
+void World::clear_stats()
+{
+    statsRecorder.clear();
+}
+
+void World::update(const int& threadCount)
+{
+    set_thread_count(threadCount);
+    update();
+}
+
+int World::get_thread_count()
+{
+    return workerPool.get_thread_count();
+}
+
+void World::set_thread_count(const int& threadCount)
+{
+    workerPool.set_thread_count(threadCount);
+}
+
+void World::set_random_seed(const unsigned int& seed)
+{
+    randomStreams.set_seed(seed);
+    randomTick = 0;
+    cavesGenerated = 0;
+}
+
+unsigned int World::get_random_seed()
+{
+    return randomStreams.get_seed();
+}
+
+// Fingerprint of everything update() reads or writes. The pheromone grid is
+// hashed in fixed blocks on the worker pool and the block hashes are folded in
+// order, so the result does not depend on the thread count either.
+std::uint64_t World::get_state_hash()
+{
+    std::uint64_t hash = hash_value(initialStateHash, randomTick);
+
+    hash = hash_value(hash, ants.size());
+    const std::vector<double>& xPositions = ants.get_x_positions();
+    const std::vector<double>& yPositions = ants.get_y_positions();
+    const std::vector<double>& orientations = ants.get_orientations();
+    const std::vector<double>& pheromoneStrengths = ants.get_pheromone_strengths();
+    for (int i = 0; i < ants.size(); i++)
+    {
+        hash = hash_double(hash, xPositions[i]);
+        hash = hash_double(hash, yPositions[i]);
+        hash = hash_double(hash, orientations[i]);
+        hash = hash_double(hash, pheromoneStrengths[i]);
+    }
+    const std::vector<std::uint64_t>& hasFoodBits = ants.get_has_food_bits();
+    for (int i = 0; i < hasFoodBits.size(); i++)
+    {
+        hash = hash_value(hash, hasFoodBits[i]);
+    }
+
+    const int blockSize = 4096;
+    int cellCount = pheromones.get_cell_count();
+    std::vector<std::uint64_t> blockHashes((cellCount + blockSize - 1)/blockSize);
+    workerPool.parallel_for(blockHashes.size(), [this, &blockHashes, cellCount](int begin, int end, int)
+    {
+        for (int block = begin; block < end; block++)
+        {
+            blockHashes[block] = pheromones.hash_cells(block*blockSize, std::min((block + 1)*blockSize, cellCount));
+        }
+    });
+    for (int i = 0; i < blockHashes.size(); i++)
+    {
+        hash = hash_value(hash, blockHashes[i]);
+    }
+
+    const std::vector<Food>& foods = foodIndex.get_foods();
+    hash = hash_value(hash, foods.size());
+    for (int i = 0; i < foods.size(); i++)
+    {
+        hash = hash_double(hash, foods[i].get_location()[0]);
+        hash = hash_double(hash, foods[i].get_location()[1]);
+        hash = hash_value(hash, std::uint32_t(foods[i].get_quantity()));
+    }
+
+    const std::vector<std::uint64_t>& obstacleWords = obstacles.get_obstacle_words();
+    for (int i = 0; i < obstacleWords.size(); i++)
+    {
+        hash = hash_value(hash, obstacleWords[i]);
+    }
+
+    hash = hash_value(hash, hasColony);
+    hash = hash_double(hash, colony.get_location()[0]);
+    return hash_double(hash, colony.get_location()[1]);
+}
+
+TrigMode World::get_trig_mode()
+{
+    return trigMode;
+}
+
+int World::get_height() const
 {
     return height;
 }
 
-int World::get_width()
+int World::get_width() const
 {
     return width;
 }
 
 std::vector<Ant> World::get_ants()
 {
-    return ants;
+    return ants.get_ants();
+}
+
+int World::get_ant_count()
+{
+    return ants.size();
 }
 
 std::vector<Food> World::get_food_vector()
 {
-    return foodVector;
+    return foodIndex.get_foods();
 }
 
 Colony World::get_colony()
@@ -70,7 +402,12 @@ int World::get_grid_scaling()
     return pheromones.get_scaling();
 }
 
-bool World::has_colony()
+int World::get_pheromone_spread() const
+{
+    return pheromoneSpread;
+}
+
+bool World::has_colony() const
 {
     return hasColony;
 }
@@ -85,19 +422,47 @@ ObstacleGrid World::get_obstacles()
     return obstacles;
 }
 
+const AntPopulation& World::view_ants() const
+{
+    return ants;
+}
+
+ConstSpan<Food> World::view_food() const
+{
+    return ConstSpan<Food>(foodIndex.get_foods());
+}
+
+const Colony& World::view_colony() const
+{
+    return colony;
+}
+
+const PheromoneGrid& World::view_pheromones() const
+{
+    return pheromones;
+}
+
+const ObstacleGrid& World::view_obstacles() const
+{
+    return obstacles;
+}
+
 void World::add_obstacle(const int& x, const int& y, const int& radius)
 {
     obstacles.add_obstacle_circle(x,y,radius);
+    repair_obstacle_distance_field();
 }
 
 void World::add_obstacle_line(const int& x1, const int& y1, const int& x2, const int& y2, const int& radius)
 {
     obstacles.add_obstacle_line(x1,y1,x2,y2,radius);
+    repair_obstacle_distance_field();
 }
 
 void World::generate_random_caves()
 {
-    obstacles.generate_random_caves();
+    PcgStream stream = randomStreams.make_stream(caveStream, cavesGenerated++);
+    obstacles.generate_random_caves(stream);
 }
 
 void World::erase_line(const int& x1, const int& y1,const int& x2, const int& y2, const int& thickness)
@@ -126,9 +491,12 @@ void World::erase_line(const int& x1, const int& y1,const int& x2, const int& y2
         for (double x = startX; x <= endX; x = x + 1)
         {
             double y = startY + slope*(x-startX);
-            erase(x,y,thickness);
+            obstacles.erase(x,y,thickness);
         }
+        erase_ants_along(x1,y1,x2,y2,thickness);
+        erase_food_along(x1,y1,x2,y2,thickness);
     }
+    repair_obstacle_distance_field();
 }
 
 void World::erase_vertical_line(const int &x, const int &y1, const int &y2, const int &thickness)
@@ -137,16 +505,18 @@ void World::erase_vertical_line(const int &x, const int &y1, const int &y2, cons
     {
         for (int y = y1; y <= y2; y++)
         {
-            erase(x,y,thickness);
+            obstacles.erase(x,y,thickness);
         }
     }
     else
     {
         for (int y = y2; y <= y1; y++)
         {
-            erase(x,y,thickness);
+            obstacles.erase(x,y,thickness);
         }
     }
+    erase_ants_along(x,y1,x,y2,thickness);
+    erase_food_along(x,y1,x,y2,thickness);
 }
 
 void World::erase(const int& x, const int& y, const int& radius)
@@ -158,38 +528,32 @@ void World::erase(const int& x, const int& y, const int& radius)
 
 void World::erase_ants(const int& x, const int& y, const int& radius)
 {
-    for (int i = 0; i < ants.size(); i++)
-    {
-        Vector3D antLocation = ants[i].get_location();
-        double antX = antLocation[0];
-        double antY = antLocation[1];
-        double distance = sqrt(pow((antX-x), 2) + pow((antY-y), 2));
-        if (distance < radius)
-        {
-            ants.erase(ants.begin()+i);
-        }
-    }
+    erase_ants_along(x,y,x,y,radius);
 }
 
 void World::erase_food(const int& x, const int& y, const int& radius)
 {
-    for (int i = 0; i < foodVector.size(); i++)
-    {
-        Vector3D foodLocation = foodVector[i].get_location();
-        double foodX = foodLocation[0];
-        double foodY = foodLocation[1];
-        double distance = sqrt(pow((foodX-x), 2) + pow((foodY-y), 2));
-        if (distance < radius)
-        {
-            foodVector.erase(foodVector.begin()+i);
-        }
-    }
+    foodIndex.remove_within(x, y, radius);
+}
+
+// A whole stroke is one capsule: ants are marked in a single scan and then
+// compacted in a single pass, whatever the stroke length.
+void World::erase_ants_along(const int& x1, const int& y1, const int& x2, const int& y2, const int& radius)
+{
+    std::vector<bool> marked(ants.size(), false);
+    ants.mark_ants_near_segment(Vector3D(x1,y1,0), Vector3D(x2,y2,0), radius, marked);
+    ants.remove_marked_ants(marked);
+}
+
+void World::erase_food_along(const int& x1, const int& y1, const int& x2, const int& y2, const int& radius)
+{
+    foodIndex.remove_near_segment(Vector3D(x1,y1,0), Vector3D(x2,y2,0), radius);
 }
 
 void World::clear_all()
 {
     ants.clear();
-    foodVector.clear();
+    foodIndex.clear();
     pheromones.clear();
     obstacles.clear();
     hasColony = false;
@@ -197,50 +561,149 @@ void World::clear_all()
 
 void World::add_ant(const Vector3D& locationVector, const double& orientationAngle)
 {
-    ants.push_back(Ant(locationVector, orientationAngle));
+    ants.add_ant(locationVector, orientationAngle);
 }
 
 void World::move_ants()
 {
+    std::vector<double>& xPositions = ants.get_x_positions();
+    std::vector<double>& yPositions = ants.get_y_positions();
+    std::vector<double>& orientations = ants.get_orientations();
+
     for (int i = 0; i < ants.size(); i++)
     {
-        ants[i].move();
-        ants[i].turn_if_at_boundary(width, height);
+        Ant ant{Vector3D(xPositions[i], yPositions[i], 0), orientations[i]};
+        ant.set_trig_mode(trigMode);
+        ant.move();
+        ant.turn_if_at_boundary(width, height);
+
+        Vector3D newLocation = ant.get_location();
+        xPositions[i] = newLocation[0];
+        yPositions[i] = newLocation[1];
+        orientations[i] = ant.get_orientation();
     }
 }
 
 void World::turn_ants()
 {
-    for (int i = 0; i < ants.size(); i++)
+    prepare_ant_turns();
+
+    // Each ant's rolls come from counters, so they do not depend on how the
+    // ants are split across workers.
+    std::uint64_t firstCounter = randomTick << 32;
+    workerPool.parallel_for(ants.size(), [this, firstCounter](int begin, int end, int worker)
+    {
+        randomStreams.fill_unit(wanderRollStream, firstCounter + begin, wanderRolls.data() + begin, end - begin);
+        randomStreams.fill_unit(cornerRollStream, firstCounter + begin, cornerRolls.data() + begin, end - begin);
+        turn_ant_range(begin, end);
+        statsRecorder.collect_thread_counters(worker);
+    });
+    randomTick++;
+}
+
+void World::prepare_ant_turns()
+{
+    statsRecorder.set_worker_count(workerPool.get_thread_count());
+    wanderRolls.resize(ants.size());
+    cornerRolls.resize(ants.size());
+
+    if (pheromones.get_sensing_mode() == summedAreaSensing)
+    {
+        build_pheromone_summed_area_tables();
+    }
+    if (obstacles.is_distance_field_enabled())
     {
-        ants[i].turn(pheromones, obstacles, foodVector, colony);
+        build_obstacle_distance_field();
+    }
+}
+
+void World::turn_ant_range(const int& begin, const int& end)
+{
+    const std::vector<double>& xPositions = ants.get_x_positions();
+    const std::vector<double>& yPositions = ants.get_y_positions();
+    std::vector<double>& orientations = ants.get_orientations();
+
+    for (int i = begin; i < end; i++)
+    {
+        Ant ant{Vector3D(xPositions[i], yPositions[i], 0), orientations[i]};
+        ant.set_trig_mode(trigMode);
+        ant.set_has_food(ants.has_food(i));
+        ant.turn(pheromones, obstacles, foodIndex, colony, wanderRolls[i], cornerRolls[i]);
+        orientations[i] = ant.get_orientation();
     }
 }
 
 void World::diminish_ant_pheromone_strengths()
 {
+    std::vector<double>& pheromoneStrengths = ants.get_pheromone_strengths();
+    double diminishValue = Ant::get_diminish_pheromone_value();
+
     for (int i = 0; i < ants.size(); i++)
     {
-        ants[i].diminish_pheromone_strength();
+        if (pheromoneStrengths[i] > diminishValue)
+        {
+            pheromoneStrengths[i] -= diminishValue;
+        }
+        else
+        {
+            pheromoneStrengths[i] = 0;
+        }
     }
 }
 
+// Each worker records its ants' deposits in its own buffer, then the grid
+// merges them one tile row per worker. Integer addition does not depend on
+// order, so this matches spreading straight into the grid exactly.
 void World::add_ant_pheromones()
 {
-    for (int i = 0; i < ants.size(); i++)
+    prepare_deposit_buffers();
+    workerPool.parallel_for(ants.size(), [this](int begin, int end, int worker)
     {
-        int x = ants[i].get_location()[0];
-        int y = ants[i].get_location()[1];
-        int pheromoneAddValue = ants[i].get_pheromone_strength();
+        deposit_ant_range(begin, end, depositBuffers[worker]);
+    });
+    merge_deposit_buffers();
+}
 
-        if (ants[i].has_food() == true)
+void World::prepare_deposit_buffers()
+{
+    depositBuffers.resize(workerPool.get_thread_count());
+    for (int i = 0; i < depositBuffers.size(); i++)
+    {
+        if (depositBuffers[i].get_tile_rows() != pheromones.get_tile_rows())
         {
-            pheromones.spread_food_pheromone(x,y,pheromoneAddValue,pheromoneSpread);
+            depositBuffers[i].resize(pheromones.get_tile_rows());
+        }
+    }
+}
+
+void World::merge_deposit_buffers()
+{
+    workerPool.parallel_for(pheromones.get_tile_rows(), [this](int begin, int end, int)
+    {
+        pheromones.merge_deposits(depositBuffers, begin, end);
+    });
+    pheromones.finish_deposits(depositBuffers);
+}
 
+void World::deposit_ant_range(const int& begin, const int& end, PheromoneDeposits& deposits)
+{
+    const std::vector<double>& xPositions = ants.get_x_positions();
+    const std::vector<double>& yPositions = ants.get_y_positions();
+    const std::vector<double>& pheromoneStrengths = ants.get_pheromone_strengths();
+
+    for (int i = begin; i < end; i++)
+    {
+        int x = xPositions[i];
+        int y = yPositions[i];
+        int pheromoneAddValue = pheromoneStrengths[i];
+
+        if (ants.has_food(i) == true)
+        {
+            deposits.spread_food_pheromone(pheromones,x,y,pheromoneAddValue,pheromoneSpread);
         }
         else
         {
-            pheromones.spread_home_pheromone(x,y,pheromoneAddValue,pheromoneSpread);
+            deposits.spread_home_pheromone(pheromones,x,y,pheromoneAddValue,pheromoneSpread);
         }
     }
 }
@@ -250,11 +713,101 @@ void World::decay_pheromones()
     pheromones.decay_all_pheromones();
 }
 
+void World::set_lazy_pheromone_decay(const bool& enabled)
+{
+    pheromones.set_lazy_decay(enabled);
+}
+
+void World::set_pheromone_sensing(const SensingMode& mode)
+{
+    pheromones.set_sensing_mode(mode);
+    if (mode == stencilSensing && pheromones.get_stencil_headings() != sensingStencilHeadings)
+    {
+        pheromones.build_sensing_stencils(Ant::get_smell_range(), sensingStencilHeadings);
+    }
+}
+
+void World::set_sensing_stencil_headings(const int& headings)
+{
+    sensingStencilHeadings = headings;
+    if (pheromones.get_sensing_mode() == stencilSensing)
+    {
+        pheromones.build_sensing_stencils(Ant::get_smell_range(), sensingStencilHeadings);
+    }
+}
+
+void World::build_pheromone_summed_area_tables()
+{
+    if (pheromones.are_summed_area_tables_current())
+    {
+        return;
+    }
+    pheromones.prepare_summed_area_tables();
+    workerPool.parallel_for(pheromones.get_grid_height(), [this](int begin, int end, int)
+    {
+        pheromones.build_summed_area_rows(begin, end);
+    });
+    workerPool.parallel_for(pheromones.get_grid_width() + 1, [this](int begin, int end, int)
+    {
+        pheromones.build_summed_area_columns(begin, end);
+    });
+    pheromones.finish_summed_area_tables();
+}
+
+// Ants never look further than their sight range, so clearances past it buy
+// nothing, and capping them there bounds what each brush stroke repairs.
+void World::set_obstacle_distance_field(const bool& enabled)
+{
+    obstacles.set_clearance_limit(Ant::get_sight_range() + 1);
+    obstacles.set_distance_field_enabled(enabled);
+}
+
+void World::set_obstacle_raycast_mode(const RaycastMode& mode)
+{
+    obstacles.set_raycast_mode(mode);
+}
+
+// Brush edits repair the field right away, so each stroke only pays for the
+// area it touched instead of piling up into a larger rebuild later.
+void World::repair_obstacle_distance_field()
+{
+    if (obstacles.is_distance_field_enabled())
+    {
+        build_obstacle_distance_field();
+    }
+}
+
+void World::build_obstacle_distance_field()
+{
+    if (obstacles.is_distance_field_current())
+    {
+        return;
+    }
+    obstacles.prepare_distance_field();
+    int firstColumn, lastColumn, firstRow, lastRow;
+    obstacles.get_distance_update_columns(firstColumn, lastColumn);
+    obstacles.get_distance_update_rows(firstRow, lastRow);
+    workerPool.parallel_for(lastColumn - firstColumn, [this, firstColumn](int begin, int end, int)
+    {
+        obstacles.build_distance_columns(firstColumn + begin, firstColumn + end);
+    });
+    workerPool.parallel_for(lastRow - firstRow, [this, firstRow](int begin, int end, int)
+    {
+        obstacles.build_distance_rows(firstRow + begin, firstRow + end);
+    });
+    obstacles.finish_distance_field();
+}
+
 void World::add_colony(const int &x, const int &y)
+{
+    add_colony(x, y, defaultNumAnts);
+}
+
+void World::add_colony(const int& x, const int& y, const int& antCount)
 {
     colony = Colony{x, y};
     hasColony = true;
-    for (int i = 0; i < defaultNumAnts; i++)
+    for (int i = 0; i < antCount; i++)
     {
         add_ant(colony.get_location(),i);
     }
@@ -266,7 +819,7 @@ void World::add_food(const int& x, const int& y, const int& quantity)
     {
         if (y > 0 && y < height - 5)
         {
-            foodVector.push_back(Food(x,y,quantity));
+            foodIndex.add(Food(x,y,quantity));
         }
     }
 }
@@ -275,48 +828,46 @@ void World::collect_food()
 {
     for (int i = 0; i < ants.size(); i++)
     {
-        int j{0};
-        Vector3D antLocation = ants[i].get_location();
-
-        while (j < foodVector.size() && ants[i].has_food() == false)
+        if (!ants.has_food(i))
         {
-            Vector3D foodLocation = foodVector[j].get_location();
-            bool nearFood = abs(antLocation[0]-foodLocation[0]) < reachForFood && abs(antLocation[1]-foodLocation[1]) < reachForFood;
-
-            if (nearFood)
-            {
-                ants[i].set_has_food(true);
-                ants[i].reset_pheromone_strength();
-                double initialOrientation = ants[i].get_orientation();
-                ants[i].set_orientation(initialOrientation + 3.14);
-
-                foodVector[j].reduce_quantity(1);
-                if (foodVector[j].get_quantity() < 1)
-                {
-                    foodVector.erase(foodVector.begin()+j);
-                }
-            }
-            j++;
+            collect_food_for(i);
         }
     }
 }
 
+void World::collect_food_for(const int& index)
+{
+    int nearest = foodIndex.find_nearest(ants.get_x_positions()[index], ants.get_y_positions()[index], reachForFood);
+    if (nearest >= 0)
+    {
+        ants.set_has_food(index, true);
+        ants.get_pheromone_strengths()[index] = Ant::get_max_pheromone_strength();
+        ants.get_orientations()[index] += 3.14;
+        foodIndex.reduce_quantity(nearest, 1);
+        ANTSIM_COUNT(foodPickupsCounter, 1);
+    }
+}
+
 void World::drop_food()
 {
+    const std::vector<double>& xPositions = ants.get_x_positions();
+    const std::vector<double>& yPositions = ants.get_y_positions();
+    std::vector<double>& orientations = ants.get_orientations();
+    std::vector<double>& pheromoneStrengths = ants.get_pheromone_strengths();
+    Vector3D colonyLocation = colony.get_location();
+
     for (int i =0 ; i < ants.size(); i++)
     {
-        if (ants[i].has_food())
+        if (ants.has_food(i))
         {
-            Vector3D antLocation = ants[i].get_location();
-            Vector3D colonyLocation = colony.get_location();
-
-            if (abs(antLocation[0]-colonyLocation[0]) < reachForFood)
+            if (abs(xPositions[i]-colonyLocation[0]) < reachForFood)
             {
-                if (abs(antLocation[1]-colonyLocation[1]) < reachForFood)
+                if (abs(yPositions[i]-colonyLocation[1]) < reachForFood)
                 {
-                    ants[i].set_has_food(false);
-                    ants[i].set_orientation(ants[i].get_orientation() + 3.14);
-                    ants[i].reset_pheromone_strength();
+                    ants.set_has_food(i, false);
+                    orientations[i] += 3.14;
+                    pheromoneStrengths[i] = Ant::get_max_pheromone_strength();
+                    ANTSIM_COUNT(foodDropsCounter, 1);
                 }
             }
         }
@@ -325,17 +876,20 @@ void World::drop_food()
 
 void World::reset_ant_pheromone_strengths()
 {
+    const std::vector<double>& xPositions = ants.get_x_positions();
+    const std::vector<double>& yPositions = ants.get_y_positions();
+    std::vector<double>& pheromoneStrengths = ants.get_pheromone_strengths();
+    Vector3D colonyLocation = colony.get_location();
+
     for (int i =0 ; i < ants.size(); i++)
     {
-        if (ants[i].has_food() == false)
+        if (ants.has_food(i) == false)
         {
-            Vector3D antLocation = ants[i].get_location();
-            Vector3D colonyLocation = colony.get_location();
-            if (abs(antLocation[0]-colonyLocation[0]) < resetPheromoneDistance)
+            if (abs(xPositions[i]-colonyLocation[0]) < resetPheromoneDistance)
             {
-                if (abs(antLocation[1]-colonyLocation[1]) < resetPheromoneDistance)
+                if (abs(yPositions[i]-colonyLocation[1]) < resetPheromoneDistance)
                 {
-                    ants[i].reset_pheromone_strength();
+                    pheromoneStrengths[i] = Ant::get_max_pheromone_strength();
                 }
             }
         }
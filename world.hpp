@@ -2,33 +2,77 @@
 #define WORLD_HPP
 
 #include "ant.hpp"
+#include "antpopulation.hpp"
 #include "vector3D.hpp"
 #include "colony.hpp"
+#include "constspan.hpp"
 #include "food.hpp"
+#include "foodindex.hpp"
 #include "pheromonegrid.hpp"
+#include "pheromonedeposits.hpp"
 #include "obstaclegrid.hpp"
+#include "randomstreams.hpp"
+#include "simstats.hpp"
+#include "workerpool.hpp"
 
+#include <chrono>
 #include <vector>
 
+// For a given seed, update() produces byte-identical state at any thread
+// count: per-ant rolls come from counter-based streams, deposits are integer
+// sums merged per cell, and food pickup, drop-off and erasing run in ant order.
+// get_state_hash() fingerprints that state for tests and benchmarks.
+
+// phasedUpdate runs each UpdatePhase as its own pass over the ants;
+// fusedUpdate does the per-ant work in one pass with identical results.
+enum UpdateMode { phasedUpdate, fusedUpdate };
+
 class World
 {
 public:
     World();
     World(const int& worldWidth, const int& worldHeight);
+    World(const int& worldWidth, const int& worldHeight, const TrigMode& trigMode);
 
     void update();
+    void update(const int& threadCount);
+    void run_phase(const UpdatePhase& phase);
+    void update_fused();
+    UpdateMode get_update_mode();
+    void set_update_mode(const UpdateMode& mode);
+
+    int get_thread_count();
+    void set_thread_count(const int& threadCount);
+    void set_random_seed(const unsigned int& seed);
+    unsigned int get_random_seed();
+    std::uint64_t get_state_hash();
+    SimulationStats stats() const;
+    void clear_stats();
+    void start_stats_phase();
+    void finish_stats_phase(const UpdatePhase& phase);
+    TrigMode get_trig_mode();
 
-    int get_height();
-    int get_width();
+    int get_height() const;
+    int get_width() const;
     std::vector<Ant> get_ants();
+    int get_ant_count();
     std::vector<Food> get_food_vector();
     Colony get_colony();
     PheromoneGrid get_pheromones();
     int get_grid_scaling();
-    bool has_colony();
+    int get_pheromone_spread() const;
+    bool has_colony() const;
     std::vector<bool> get_obstacle_vector();
     ObstacleGrid get_obstacles();
 
+    // Views onto the live state for readers such as the renderer; they skip
+    // the copies above but are only valid until the next update or edit.
+    const AntPopulation& view_ants() const;
+    ConstSpan<Food> view_food() const;
+    const Colony& view_colony() const;
+    const PheromoneGrid& view_pheromones() const;
+    const ObstacleGrid& view_obstacles() const;
+
     void add_obstacle(const int& x, const int& y, const int& radius);
     void add_obstacle_line(const int& x1, const int& y1, const int& x2, const int& y2, const int& radius);
     void generate_random_caves();
@@ -38,26 +82,45 @@ public:
     void erase(const int& x, const int& y, const int& radius);
     void erase_ants(const int& x, const int& y, const int& radius);
     void erase_food(const int& x, const int& y, const int& radius);
+    void erase_ants_along(const int& x1, const int& y1, const int& x2, const int& y2, const int& radius);
+    void erase_food_along(const int& x1, const int& y1, const int& x2, const int& y2, const int& radius);
     void clear_all();
 
     void add_ant(const Vector3D& locationVector, const double& orientationAngle);
     void move_ants();
     void turn_ants();
+    void prepare_ant_turns();
+    void turn_ant_range(const int& begin, const int& end);
+    void update_ant_range(const int& begin, const int& end, PheromoneDeposits& deposits, std::vector<int>& candidates);
+    void finish_ant(const int& index);
 
     void diminish_ant_pheromone_strengths();
     void add_ant_pheromones();
+    void deposit_ant_range(const int& begin, const int& end, PheromoneDeposits& deposits);
+    void prepare_deposit_buffers();
+    void merge_deposit_buffers();
     void decay_pheromones();
+    void set_lazy_pheromone_decay(const bool& enabled);
+    void set_pheromone_sensing(const SensingMode& mode);
+    void set_sensing_stencil_headings(const int& headings);
+    void build_pheromone_summed_area_tables();
+    void set_obstacle_distance_field(const bool& enabled);
+    void build_obstacle_distance_field();
+    void repair_obstacle_distance_field();
+    void set_obstacle_raycast_mode(const RaycastMode& mode);
 
     void add_colony(const int& x, const int& y);
+    void add_colony(const int& x, const int& y, const int& antCount);
     void add_food(const int& x, const int& y, const int& quantity);
 
     void collect_food();
+    void collect_food_for(const int& index);
     void drop_food();
     void reset_ant_pheromone_strengths();
 
 protected:
-    std::vector<Ant> ants{};
-    std::vector<Food> foodVector;
+    AntPopulation ants;
+    FoodIndex foodIndex;
     Colony colony;
     PheromoneGrid pheromones;
     ObstacleGrid obstacles;
@@ -65,11 +128,25 @@ protected:
     int pheromoneGridScaling{1};
     int defaultNumAnts{300};
     int pheromoneSpread{3};
+    int sensingStencilHeadings{256};
     int reachForFood{5};
     int resetPheromoneDistance{8};
     int height;
     int width;
     double pi = 3.141592654;
+    TrigMode trigMode{libmTrig};
+
+    WorkerPool workerPool;
+    RandomStreams randomStreams;
+    std::uint64_t randomTick{0};
+    std::uint64_t cavesGenerated{0};
+    std::vector<double> wanderRolls;
+    std::vector<double> cornerRolls;
+    std::vector<PheromoneDeposits> depositBuffers;
+    std::vector<std::vector<int>> pickupCandidates;
+    UpdateMode updateMode{phasedUpdate};
+    StatsRecorder statsRecorder;
+    std::chrono::steady_clock::time_point phaseStart;
 };
 
 #endif // WORLD_HPP
@@ -0,0 +1,23 @@
+#include "worldcommands.hpp"
+
+void WorldCommandQueue::post(const WorldCommand& command)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.push_back(command);
+}
+
+// Commands run outside the lock so a slow edit never blocks the poster.
+int WorldCommandQueue::run_pending(World& world)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running.swap(pending);
+    }
+    int commandCount = running.size();
+    for (int i = 0; i < running.size(); i++)
+    {
+        running[i](world);
+    }
+    running.clear();
+    return commandCount;
+}
@@ -0,0 +1,26 @@
+#ifndef WORLDCOMMANDS_HPP
+#define WORLDCOMMANDS_HPP
+
+#include "world.hpp"
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+typedef std::function<void(World&)> WorldCommand;
+
+// Edits posted from the GUI thread for the simulation thread to apply between
+// ticks, in the order they were posted.
+class WorldCommandQueue
+{
+public:
+    void post(const WorldCommand& command);
+    int run_pending(World& world);
+
+private:
+    std::mutex mutex;
+    std::vector<WorldCommand> pending;
+    std::vector<WorldCommand> running;
+};
+
+#endif // WORLDCOMMANDS_HPP